@@ -49,6 +49,15 @@
     #define NS_NOEXCEPT     throw ()
 #endif
 
+//------------------------------------------------------------------------------
+// C++17起不再允许动态异常说明
+
+#if __cplusplus >= 201703L
+    #define NS_THROW(...)
+#else
+    #define NS_THROW(...)   throw (__VA_ARGS__)
+#endif
+
 //------------------------------------------------------------------------------
 //
 
@@ -31,6 +31,14 @@
  *                  \li 默认内存分配器
  *                  \li 非侵入式Object Pool
  *                  \li 侵入式Object Pool
+ *                  \li 按尺寸分级的Memory Pool
+ *                  \li 双缓冲的帧线性分配器
+ *                  \li 基于mmap的大页内存分配器
+ *                  \li 供标准库容器使用的Object Pool分配器
+ *                  \li std::pmr::memory_resource实现(C++17)
+ *                  \li 基于版本号句柄的Slot Map
+ *                  \li 按NUMA结点分配内存的Object Pool
+ *                  \li 支持跨线程删除的单拥有者Object Pool
  *
  * \subsection      NsSynchronization
  *                  \li 默认锁变量类型
@@ -0,0 +1,92 @@
+#ifndef NS_TYPE_TRAITS_H
+#define	NS_TYPE_TRAITS_H
+
+#include <type_traits>
+
+namespace NsLib
+{
+
+/*!
+ * \internal
+ * \brief   编译期真值，作为函数重载的标签使用。
+ * \endinternal
+ */
+struct True_
+{
+    static const bool value = true;
+};
+
+/*!
+ * \internal
+ * \brief   编译期假值，作为函数重载的标签使用。
+ * \endinternal
+ */
+struct False_
+{
+    static const bool value = false;
+};
+
+/*!
+ * \internal
+ * \brief   将bool常量转换为True_或False_。
+ * \endinternal
+ */
+template <bool condition>
+struct BoolType_
+{
+    typedef False_  Type;
+};
+
+template <>
+struct BoolType_<true>
+{
+    typedef True_   Type;
+};
+
+/*!
+ * \internal
+ * \class   TypeTraits NsTypeTraits.h
+ * \brief   类型特性，结果为True_或False_，用于在编译期选择实现。
+ *
+ * \tparam  DataType - 要萃取的类型
+ *
+ * \details IsPodType - 只有内置类型、枚举和指针为True_，
+ *                      用户定义的类型一律视为非POD，需要时可以特化TypeTraits。\n
+ *          HasTrivialDestructor - 析构函数什么都不做，可以省略析构调用。\n
+ *          IsTriviallyCopyable - 可以直接用memcpy()搬移对象。
+ *
+ * \code
+ * // 示例：
+ * template <typename DataType>
+ * void destroy(DataType *ptr, ::NsLib::True_)
+ * {
+ * }
+ *
+ * template <typename DataType>
+ * void destroy(DataType *ptr, ::NsLib::False_)
+ * {
+ *      ptr->~DataType();
+ * }
+ *
+ * destroy(ptr, typename ::NsLib::TypeTraits<DataType>::HasTrivialDestructor());
+ * \endcode
+ * \endinternal
+ */
+template <typename DataType>
+struct TypeTraits
+{
+    typedef typename BoolType_<std::is_scalar<DataType>::value>::Type
+            IsPodType;
+
+    typedef typename BoolType_<
+                std::is_trivially_destructible<DataType>::value>::Type
+            HasTrivialDestructor;
+
+    typedef typename BoolType_<
+                std::is_trivially_copyable<DataType>::value>::Type
+            IsTriviallyCopyable;
+};
+
+}   // NsLib
+
+#endif
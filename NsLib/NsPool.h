@@ -26,7 +26,18 @@
 #include "NsUtility/NsUncopyale.h"
 
 #include "NsPool/NsObjectPool.h"
+#include "NsPool/NsMemoryPool.h"
 #include "NsPool/NsINewFromObjectPool.h"
+#include "NsPool/NsThreadCachedObjectPool.h"
+#include "NsPool/NsConcurrentObjectPool.h"
+#include "NsPool/NsGrowableObjectPool.h"
+#include "NsPool/NsFrameArena.h"
+#include "NsPool/NsHugePageAllocator.h"
+#include "NsPool/NsObjectPoolAllocator.h"
+#include "NsPool/NsMemoryResource.h"
+#include "NsPool/NsSlotMap.h"
+#include "NsPool/NsNumaObjectPool.h"
+#include "NsPool/NsRemoteFreeObjectPool.h"
 
 #endif
 
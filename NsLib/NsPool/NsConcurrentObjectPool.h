@@ -0,0 +1,368 @@
+#ifndef NS_CONCURRENT_OBJECT_POOL_H
+#define	NS_CONCURRENT_OBJECT_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstdint>
+#include <atomic>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   ConcurrentObjectPool NsPool.h
+ * \brief   无锁的Object Pool，多个线程可以同时分配和删除对象。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
+ *
+ * \details 与ObjectPool使用相同的内存布局和相同的宏，区别在于：\n
+ *          空闲链表是一个无锁的Treiber stack，链表头由[版本号 | 块索引]组成，
+ *          每次修改链表头都会递增版本号，以此避免ABA问题；\n
+ *          从未分配过的区域使用原子的fetch-add进行顺序分配。\n
+ *          因此getObjectMemory()和deleteObject()不需要任何NsLcok。
+ *
+ * \note    create()和destroy()不是线程安全的，请在工作线程启动前创建，
+ *          在所有工作线程结束后销毁。\n
+ *          容量耗尽时，Debug模式下会触发断言，Release模式下抛出bad_alloc。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_CONCURRENT_OBJECT_POOL_NAME(ProjectilePool, Projectile, 50000);
+ *
+ * NS_CREATE_OBJECT_POOL(ProjectilePool);
+ *
+ * // 在任意线程中：
+ * Projectile *projectile = NS_NEW_FROM_OBJECT_POOL(ProjectilePool, origin);
+ * NS_DELETE_IN_OBJECT_POOL(ProjectilePool, projectile);
+ *
+ * NS_DESTROY_OBJECT_POOL(ProjectilePool);
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class ConcurrentObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(ConcurrentObjectPool);
+
+    static_assert(capacity < UINT32_MAX,
+                  "-- capacity of ConcurrentObjectPool must fit in 32 bits");
+
+    typedef Allocator<DataType> PoolAllocator;
+
+    // 空闲块中保存下一个空闲块的索引 + 1, 0表示链表结束
+    struct FreeBlockNode
+    {
+        std::atomic<uint32_t>   next_;
+    };
+
+    // 块中的next_是原子变量, 每个块都要满足它的对齐要求
+    static const size_t blockAlignment_ =
+        alignof(DataType) < alignof(FreeBlockNode)
+        ? alignof(FreeBlockNode)
+        : alignof(DataType);
+
+    // 链表头: 高32位为版本号, 低32位为块索引 + 1
+    static const uint64_t indexMask_ = 0xFFFFFFFFull;
+    static const uint64_t tagIncrement_ = 0x100000000ull;
+
+public:
+    typedef DataType    DataType_;
+
+    ~ConcurrentObjectPool()
+    {
+        if (!isDestroyed())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建Object Pool，分配所需内存。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!getInstance().isCreated()
+               && "-- you have already create the object pool");
+
+        getInstance().init();
+    }
+
+    /*!
+     * \brief   销毁Object Pool，并释放所有分配的内存。
+     *
+     * \note    Debug模式下如果没有创建Pool而直接调用此函数会触发断言。
+     */
+    static void destroy()
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a object pool");
+
+        if (!getInstance().isDestroyed())
+        {
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+            NS_TRACE_MEMORY("ConcurrentObjectPool<",
+                            typeid(DataType).name(),
+                            ">::destroy()",
+                            getInstance().poolMemPtr_);
+#endif
+
+            PoolAllocator::deallocate(getInstance().poolMemPtr_);
+
+            getInstance().poolMemPtr_ = nullptr;
+            getInstance().alignedMemPtr_ = nullptr;
+            getInstance().firstFreeBlock_.store(0, std::memory_order_relaxed);
+            getInstance().nextUnusedBlock_.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static DataType *getObjectMemory()
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        DataType *ptr = getInstance().getMemoryBlock();
+
+        NS_TRACE_MEMORY("ConcurrentObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getObject()",
+                        ptr);
+        return ptr;
+#else
+        return getInstance().getMemoryBlock();
+#endif
+    }
+
+    static void deleteObject(DataType *objectPtr)
+    {
+        assert(getInstance().isPointerValid(objectPtr)
+               && "-- the object is not allocated from this object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ConcurrentObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deleteObject()",
+                        objectPtr);
+#endif
+
+        objectPtr->~DataType();
+
+        getInstance().returnMemoryBlock(objectPtr);
+    }
+
+    static void deallocateMemory(DataType *objectPtr)
+    {
+        assert(getInstance().isPointerValid(objectPtr)
+               && "-- the object is not allocated from this object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ConcurrentObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        getInstance().returnMemoryBlock(objectPtr);
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    ConcurrentObjectPool() :
+        capacity_{capacity},
+        poolMemPtr_{nullptr},
+        alignedMemPtr_{nullptr},
+        firstFreeBlock_{0},
+        nextUnusedBlock_{0}
+    {
+        if (sizeof(DataType) <= sizeof(FreeBlockNode))
+        {
+            dataSize_ = sizeof(FreeBlockNode);
+        }
+        else
+        {
+            dataSize_ = sizeof(DataType);
+        }
+
+        dataSize_ = (dataSize_ + blockAlignment_ - 1) & ~(blockAlignment_ - 1);
+    }
+
+    static ConcurrentObjectPool<DataType, capacity, Allocator> &getInstance()
+    {
+        static ConcurrentObjectPool<DataType, capacity, Allocator> poolInstance;
+
+        return poolInstance;
+    }
+
+    void init()
+    {
+        // 不需要ObjectPool中用于保存firstFreeBlock_的额外块,
+        // 未分配区域由nextUnusedBlock_单独维护
+        size_t size = dataSize_ * capacity_ + blockAlignment_;
+
+        poolMemPtr_ = PoolAllocator::allocate(size);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ConcurrentObjectPool<",
+                        typeid(DataType).name(),
+                        ">::init() poolMemPtr",
+                        poolMemPtr_);
+#endif
+
+        alignedMemPtr_ = (DataType *)(
+            ((uintptr_t)(poolMemPtr_) + blockAlignment_ - 1)
+            & (uintptr_t)(~(blockAlignment_ - 1)));
+
+        firstFreeBlock_.store(0, std::memory_order_relaxed);
+        nextUnusedBlock_.store(0, std::memory_order_release);
+    }
+
+    bool isCreated()
+    {
+        return nullptr == alignedMemPtr_ ? false : true;
+    }
+
+    bool isDestroyed()
+    {
+        return nullptr == poolMemPtr_ ? true: false;
+    }
+
+    bool isPointerValid(DataType *ptr)
+    {
+        return (nullptr != ptr
+                && (char *)(alignedMemPtr_) <= (char *)(ptr)
+                && (char *)(ptr)
+                   <= (char *)(alignedMemPtr_) + dataSize_ * (capacity_ - 1));
+    }
+
+    FreeBlockNode *getBlock(uint64_t index)
+    {
+        return (FreeBlockNode *)((char *)(alignedMemPtr_) + dataSize_ * index);
+    }
+
+    DataType *getMemoryBlock()
+    {
+        uint64_t head = firstFreeBlock_.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            uint64_t index = head & indexMask_;
+
+            if (0 == index)
+            {
+                // 空闲链表为空, 走顺序分配
+                if (nextUnusedBlock_.load(std::memory_order_relaxed) < capacity_)
+                {
+                    size_t unused = nextUnusedBlock_.fetch_add(
+                                        1, std::memory_order_relaxed);
+
+                    if (unused < capacity_)
+                    {
+                        return (DataType *)(getBlock(unused));
+                    }
+                }
+
+                // 顺序分配失败期间, 其他线程可能归还了对象
+                head = firstFreeBlock_.load(std::memory_order_acquire);
+
+                if (0 == (head & indexMask_))
+                {
+                    assert(false && "-- the object pool has not enough object");
+                    throw std::bad_alloc();
+                }
+
+                continue;
+            }
+
+            FreeBlockNode *object = getBlock(index - 1);
+
+            // 读到的next_可能已经被其他线程修改, 但此时版本号必然也已改变,
+            // 下面的CAS会失败并重试
+            uint64_t next = object->next_.load(std::memory_order_relaxed);
+            uint64_t newHead = ((head & ~indexMask_) + tagIncrement_) | next;
+
+            if (firstFreeBlock_.compare_exchange_weak(
+                    head, newHead,
+                    std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return (DataType *)(object);
+            }
+        }
+    }
+
+    void returnMemoryBlock(DataType *objectPtr)
+    {
+        uint64_t index = ((char *)(objectPtr) - (char *)(alignedMemPtr_))
+                         / dataSize_;
+        FreeBlockNode *objectBlock = ::new((void *)(objectPtr)) FreeBlockNode;
+        uint64_t head = firstFreeBlock_.load(std::memory_order_relaxed);
+        uint64_t newHead;
+
+        do
+        {
+            objectBlock->next_.store((uint32_t)(head & indexMask_),
+                                     std::memory_order_relaxed);
+            newHead = ((head & ~indexMask_) + tagIncrement_) | (index + 1);
+        } while (!firstFreeBlock_.compare_exchange_weak(
+                     head, newHead,
+                     std::memory_order_release, std::memory_order_relaxed));
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    size_t                  capacity_;
+    size_t                  dataSize_;
+    DataType                *poolMemPtr_;       // 实际分配内存首地址, 用于释放
+    DataType                *alignedMemPtr_;    // 满足内存对齐要求的首地址
+    std::atomic<uint64_t>   firstFreeBlock_;    // 空闲链表头[版本号 | 索引 + 1]
+    std::atomic<size_t>     nextUnusedBlock_;   // 第一个从未分配过的块的索引
+};
+
+/*!
+ * \brief   定义无锁Object Pool的名字。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   存储的数据类型
+ * \param   [可选]容量[默认=1000]
+ * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ *
+ * \details 定义后即可使用NS_CREATE_OBJECT_POOL, NS_NEW_FROM_OBJECT_POOL,
+ *          NS_DELETE_IN_OBJECT_POOL, NS_DESTROY_OBJECT_POOL进行操作。
+ *
+ * \see     ConcurrentObjectPool
+ */
+#define NS_DEFINE_CONCURRENT_OBJECT_POOL_NAME(PoolName, ...) \
+    typedef ::NsLib::ConcurrentObjectPool<__VA_ARGS__> PoolName
+
+}   // NsLib
+
+#endif
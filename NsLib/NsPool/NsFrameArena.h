@@ -0,0 +1,257 @@
+#ifndef NS_FRAME_ARENA_H
+#define	NS_FRAME_ARENA_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   FrameArena NsPool.h
+ * \brief   双缓冲的线性分配器，用于每帧(tick)的临时数据。
+ * \ingroup NsPool
+ *
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details create()时从Allocator申请两个frameSize大小的帧，分配只是在当前帧内
+ *          移动指针，没有任何释放操作。\n
+ *          nextFrame()切换到另一帧并将其清空，上一帧的数据在下一次nextFrame()之前
+ *          仍然有效，所以第N帧构建的数据可以在第N + 1帧中继续读取。\n
+ *          reset()只清空当前帧，时间复杂度O(1)。
+ *
+ * \note    不会调用任何析构函数，只适合存放析构函数为trivial的数据，
+ *          如命中列表、可见集合、消息批次等。\n
+ *          当前帧空间不足时，Debug模式下会触发断言，Release模式下抛出bad_alloc。\n
+ *          不是线程安全的，每个线程应持有自己的FrameArena。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::FrameArena<> frameArena;
+ *
+ * frameArena.create(4 * 1024 * 1024);
+ *
+ * while (running)
+ * {
+ *      // 上一帧的visibleSet在这里仍然有效。
+ *      EntityId *visibleSet = frameArena.allocateArray<EntityId>(count);
+ *
+ *      // ...
+ *
+ *      frameArena.nextFrame();
+ * }
+ *
+ * frameArena.destroy();
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class FrameArena
+{
+    MAKE_CLASS_UNCOPYABLE(FrameArena);
+
+    typedef Allocator<char> ArenaAllocator;
+
+    struct Frame
+    {
+        char    *begin_;
+        char    *current_;
+        char    *end_;
+    };
+
+public:
+    FrameArena() :
+        frameSize_{0},
+        arenaMemPtr_{nullptr},
+        currentFrame_{0}
+    {
+        for (size_t i = 0; i < 2; ++i)
+        {
+            frames_[i].begin_ = nullptr;
+            frames_[i].current_ = nullptr;
+            frames_[i].end_ = nullptr;
+        }
+    }
+
+    ~FrameArena()
+    {
+        if (isCreated())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建FrameArena，分配两个帧所需的内存。
+     *
+     * \param   frameSize - 每一帧的字节数
+     *
+     * \return  无
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    void create(size_t frameSize) NS_THROW(std::bad_alloc)
+    {
+        assert(!isCreated()
+               && "-- you have already create the frame arena");
+        assert(0 < frameSize && "-- frameSize must be greater than 0");
+
+        arenaMemPtr_ = ArenaAllocator::allocate(frameSize * 2);
+        frameSize_ = frameSize;
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("FrameArena<",
+                        frameSize,
+                        ">::create() arenaMemPtr_",
+                        (void *)(arenaMemPtr_));
+#endif
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            frames_[i].begin_ = arenaMemPtr_ + frameSize * i;
+            frames_[i].current_ = frames_[i].begin_;
+            frames_[i].end_ = frames_[i].begin_ + frameSize;
+        }
+
+        currentFrame_ = 0;
+    }
+
+    /*!
+     * \brief   销毁FrameArena，释放两个帧的内存。
+     *
+     * \note    Debug模式下如果没有创建而直接调用此函数会触发断言。
+     */
+    void destroy()
+    {
+        assert(isCreated()
+               && "-- you have not create a frame arena");
+
+        ArenaAllocator::deallocate(arenaMemPtr_);
+
+        arenaMemPtr_ = nullptr;
+    }
+
+    /*!
+     * \brief   在当前帧中分配size字节，首地址按alignment对齐。
+     *
+     * \param   size - 要分配的字节数
+     * \param   [可选]alignment - 对齐要求，必须是2的幂[默认 = alignof(max_align_t)]
+     *
+     * \return  内存块首地址
+     *
+     * \throw   bad_alloc
+     */
+    void *allocate(size_t size,
+                   size_t alignment = alignof(std::max_align_t))
+        NS_THROW(std::bad_alloc)
+    {
+        assert(isCreated()
+               && "-- you have not create a frame arena");
+        assert(0 == (alignment & (alignment - 1))
+               && "-- alignment must be a power of 2");
+
+        Frame &frame = frames_[currentFrame_];
+
+        char *memPtr = (char *)(
+            ((uintptr_t)(frame.current_) + alignment - 1)
+            & (uintptr_t)(~(alignment - 1)));
+
+        if (memPtr > frame.end_ || (size_t)(frame.end_ - memPtr) < size)
+        {
+            assert(false && "-- the frame arena has not enough memory");
+            throw std::bad_alloc();
+        }
+
+        frame.current_ = memPtr + size;
+
+        return memPtr;
+    }
+
+    /*!
+     * \brief   在当前帧中分配count个DataType，不进行构造。
+     *
+     * \throw   bad_alloc
+     */
+    template <typename DataType>
+    DataType *allocateArray(size_t count) NS_THROW(std::bad_alloc)
+    {
+        return static_cast<DataType *>(
+            allocate(sizeof(DataType) * count, alignof(DataType)));
+    }
+
+    /*!
+     * \brief   清空当前帧，时间复杂度O(1)。
+     *
+     * \note    当前帧中之前分配的所有指针都将失效，上一帧不受影响。
+     */
+    void reset()
+    {
+        assert(isCreated()
+               && "-- you have not create a frame arena");
+
+        frames_[currentFrame_].current_ = frames_[currentFrame_].begin_;
+    }
+
+    /*!
+     * \brief   切换到下一帧。
+     *
+     * \details 当前帧变为上一帧并保持有效，原来的上一帧被清空后作为新的当前帧。
+     */
+    void nextFrame()
+    {
+        assert(isCreated()
+               && "-- you have not create a frame arena");
+
+        currentFrame_ ^= 1;
+
+        frames_[currentFrame_].current_ = frames_[currentFrame_].begin_;
+    }
+
+    /*!
+     * \brief   当前帧已经使用的字节数。
+     */
+    size_t getUsedSize() const
+    {
+        return frames_[currentFrame_].current_ - frames_[currentFrame_].begin_;
+    }
+
+    size_t getFrameSize() const
+    {
+        return frameSize_;
+    }
+
+    bool isCreated() const
+    {
+        return nullptr == arenaMemPtr_ ? false : true;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    size_t      frameSize_;
+    char        *arenaMemPtr_;      // 两个帧共用的内存首地址, 用于释放
+    Frame       frames_[2];
+    size_t      currentFrame_;      // 当前帧的下标, 0或1
+};
+
+}   // NsLib
+
+#endif
@@ -0,0 +1,402 @@
+#ifndef NS_GROWABLE_OBJECT_POOL_H
+#define	NS_GROWABLE_OBJECT_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstdint>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   GrowableObjectPool NsPool.h
+ * \brief   按需增长的Object Pool，容量不足时从Allocator申请新的slab并链接起来。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 第一个slab的容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
+ * \tparam  [可选]size_t growthPercent - 新slab容量相对上一个slab的百分比[默认 = 200]
+ * \tparam  [可选]size_t maxCapacity - 所有slab容量之和的上限，0表示不限制[默认 = 0]
+ *
+ * \details 每个slab的内存布局与ObjectPool完全相同，所有slab共享同一个空闲链表。\n
+ *          只有在所有slab都被占满时才会申请新的slab，所以分配的快速路径与ObjectPool相同，
+ *          只多了一次容量判断。\n
+ *          growthPercent = 200表示每个新slab的容量是上一个的2倍，150表示1.5倍，
+ *          100表示每次增长固定的capacity个。
+ *
+ * \note    达到maxCapacity后继续分配，Debug模式下会触发断言，Release模式下抛出bad_alloc，
+ *          不会像ObjectPool那样越过内存块末尾。\n
+ *          slab只在destroy()时释放。
+ *
+ * \code
+ * // 示例：
+ * // 初始容量1000，每次增长为上一个slab的1.5倍，最多容纳100000个对象。
+ * NS_DEFINE_GROWABLE_OBJECT_POOL_NAME(MonsterPool, Monster, 1000,
+ *                                     ::NsLib::UserDefaultAllocator,
+ *                                     150, 100000);
+ *
+ * NS_CREATE_OBJECT_POOL(MonsterPool);
+ *
+ * Monster *monster = NS_NEW_FROM_OBJECT_POOL(MonsterPool, level);
+ * NS_DELETE_IN_OBJECT_POOL(MonsterPool, monster);
+ *
+ * NS_DESTROY_OBJECT_POOL(MonsterPool);
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator,
+          size_t    growthPercent = 200,
+          size_t    maxCapacity = 0>
+class GrowableObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(GrowableObjectPool);
+
+    static_assert(0 < capacity, "-- capacity must be greater than 0");
+    static_assert(100 <= growthPercent, "-- growthPercent must be >= 100");
+    static_assert(0 == maxCapacity || capacity <= maxCapacity,
+                  "-- capacity must not exceed maxCapacity");
+
+    typedef Allocator<DataType> PoolAllocator;
+
+    struct FreeBlockNode
+    {
+        FreeBlockNode   *pNext_;
+    };
+
+    // 保存在每个slab实际分配内存的开头
+    struct SlabHeader
+    {
+        SlabHeader      *pNext_;
+        size_t          capacity_;
+        DataType        *alignedMemPtr_;
+    };
+
+public:
+    typedef DataType    DataType_;
+
+    ~GrowableObjectPool()
+    {
+        if (!isDestroyed())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建Object Pool，分配第一个slab。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!getInstance().isCreated()
+               && "-- you have already create the object pool");
+
+        getInstance().init();
+    }
+
+    /*!
+     * \brief   销毁Object Pool，并释放所有slab。
+     *
+     * \note    Debug模式下如果没有创建Pool而直接调用此函数会触发断言。
+     */
+    static void destroy()
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a object pool");
+
+        SlabHeader *slab = getInstance().firstSlab_;
+
+        while (nullptr != slab)
+        {
+            SlabHeader *next = slab->pNext_;
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+            NS_TRACE_MEMORY("GrowableObjectPool<",
+                            typeid(DataType).name(),
+                            ">::destroy() slab",
+                            slab);
+#endif
+
+            PoolAllocator::deallocate((DataType *)(slab));
+            slab = next;
+        }
+
+        getInstance().firstSlab_ = nullptr;
+        getInstance().totalCapacity_ = 0;
+        getInstance().currentCapacity_ = 0;
+    }
+
+    static DataType *getObjectMemory() NS_THROW(std::bad_alloc)
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a object pool");
+
+        if (0 == getInstance().currentCapacity_)
+        {
+            getInstance().grow();
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        DataType *ptr = getInstance().getMemoryBlock();
+
+        NS_TRACE_MEMORY("GrowableObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getObject()",
+                        ptr);
+        return ptr;
+#else
+        return getInstance().getMemoryBlock();
+#endif
+    }
+
+    static void deleteObject(DataType *objectPtr)
+    {
+        assert(getInstance().isPointerValid(objectPtr)
+               && "-- the object is not allocated from this object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("GrowableObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deleteObject()",
+                        objectPtr);
+#endif
+
+        objectPtr->~DataType();
+
+        getInstance().returnMemoryBlock((FreeBlockNode *)(objectPtr));
+    }
+
+    static void deallocateMemory(DataType *objectPtr)
+    {
+        assert(getInstance().isPointerValid(objectPtr)
+               && "-- the object is not allocated from this object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("GrowableObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        getInstance().returnMemoryBlock((FreeBlockNode *)(objectPtr));
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    GrowableObjectPool() :
+        totalCapacity_{0},
+        currentCapacity_{0},
+        firstSlab_{nullptr},
+        lastSlab_{nullptr},
+        firstFreeBlock_{nullptr}
+    {
+        if (sizeof(DataType) <= sizeof(FreeBlockNode *))
+        {
+            dataSize_ = sizeof(FreeBlockNode *);
+        }
+        else
+        {
+            dataSize_ = sizeof(DataType);
+        }
+    }
+
+    static GrowableObjectPool<DataType, capacity, Allocator,
+                              growthPercent, maxCapacity> &getInstance()
+    {
+        static GrowableObjectPool<DataType, capacity, Allocator,
+                                  growthPercent, maxCapacity> poolInstance;
+
+        return poolInstance;
+    }
+
+    void init()
+    {
+        lastSlab_ = nullptr;
+
+        addSlab(capacity);
+    }
+
+    // 申请一个容量为slabCapacity的slab, 并将其作为新的未分配区域,
+    // 调用时空闲链表中只剩下上一个slab末尾的哨兵块
+    void addSlab(size_t slabCapacity)
+    {
+        // 与ObjectPool相同, 多分配一个dataSize_作为哨兵块
+        size_t size = sizeof(SlabHeader)
+                      + dataSize_ * (slabCapacity + 1) + alignof(DataType);
+
+        SlabHeader *slab = (SlabHeader *)(PoolAllocator::allocate(size));
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("GrowableObjectPool<",
+                        typeid(DataType).name(),
+                        ">::addSlab() slab",
+                        slab);
+#endif
+
+        slab->pNext_ = nullptr;
+        slab->capacity_ = slabCapacity;
+        slab->alignedMemPtr_ = (DataType *)(
+            ((uintptr_t)(slab + 1) + alignof(DataType) - 1)
+            & (uintptr_t)(~(alignof(DataType) - 1)));
+
+        if (nullptr == lastSlab_)
+        {
+            firstSlab_ = slab;
+        }
+        else
+        {
+            lastSlab_->pNext_ = slab;
+        }
+
+        lastSlab_ = slab;
+
+        totalCapacity_ += slabCapacity;
+        currentCapacity_ += slabCapacity;
+
+        firstFreeBlock_ = (FreeBlockNode *)(slab->alignedMemPtr_);
+        firstFreeBlock_->pNext_ = nullptr;
+    }
+
+    void grow() NS_THROW(std::bad_alloc)
+    {
+        size_t slabCapacity = lastSlab_->capacity_ * growthPercent / 100;
+
+        if (0 != maxCapacity && maxCapacity - totalCapacity_ < slabCapacity)
+        {
+            slabCapacity = maxCapacity - totalCapacity_;
+        }
+
+        if (0 == slabCapacity)
+        {
+            assert(false && "-- the object pool has reached maxCapacity");
+            throw std::bad_alloc();
+        }
+
+#ifdef _NS_DEBUG_
+        NS_DEBUG_MESSAGE_4("GrowableObjectPool<",
+                           typeid(DataType).name(),
+                           ">::grow() slabCapacity: ",
+                           slabCapacity);
+#endif
+
+        addSlab(slabCapacity);
+    }
+
+    bool isCreated()
+    {
+        return nullptr == firstSlab_ ? false : true;
+    }
+
+    bool isDestroyed()
+    {
+        return nullptr == firstSlab_ ? true : false;
+    }
+
+    bool isPointerValid(DataType *ptr)
+    {
+        if (nullptr == ptr)
+        {
+            return false;
+        }
+
+        for (SlabHeader *slab = firstSlab_;
+             nullptr != slab;
+             slab = slab->pNext_)
+        {
+            if ((char *)(slab->alignedMemPtr_) <= (char *)(ptr)
+                && (char *)(ptr) <= (char *)(slab->alignedMemPtr_)
+                                    + dataSize_ * (slab->capacity_ - 1))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    DataType *getMemoryBlock()
+    {
+        FreeBlockNode *object = firstFreeBlock_;
+
+        --currentCapacity_;
+
+        if (nullptr == firstFreeBlock_->pNext_)
+        {
+            firstFreeBlock_ = (FreeBlockNode *)(
+                (char *)(firstFreeBlock_) + dataSize_);
+            firstFreeBlock_->pNext_ = nullptr;
+        }
+        else
+        {
+            firstFreeBlock_ = firstFreeBlock_->pNext_;
+        }
+
+        return static_cast<DataType *>(reinterpret_cast<void *>(object));
+    }
+
+    void returnMemoryBlock(FreeBlockNode *objectBlock)
+    {
+        objectBlock->pNext_ = firstFreeBlock_;
+        firstFreeBlock_ = objectBlock;
+
+        ++currentCapacity_;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    size_t               dataSize_;
+    size_t               totalCapacity_;    // 所有slab的容量之和
+    size_t               currentCapacity_;  // 所有slab中剩余的空闲块数
+    SlabHeader           *firstSlab_;       // slab链表, 用于释放和指针检测
+    SlabHeader           *lastSlab_;        // 最新的slab, 未分配区域所在
+    FreeBlockNode        *firstFreeBlock_;  // 第一个未分配结点
+};
+
+/*!
+ * \brief   定义可增长Object Pool的名字。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   存储的数据类型
+ * \param   [可选]第一个slab的容量[默认=1000]
+ * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ * \param   [可选]增长百分比[默认=200]
+ * \param   [可选]容量上限，0表示不限制[默认=0]
+ *
+ * \details 定义后即可使用NS_CREATE_OBJECT_POOL, NS_NEW_FROM_OBJECT_POOL,
+ *          NS_DELETE_IN_OBJECT_POOL, NS_DESTROY_OBJECT_POOL进行操作。
+ *
+ * \see     GrowableObjectPool
+ */
+#define NS_DEFINE_GROWABLE_OBJECT_POOL_NAME(PoolName, ...) \
+    typedef ::NsLib::GrowableObjectPool<__VA_ARGS__> PoolName
+
+}   // NsLib
+
+#endif
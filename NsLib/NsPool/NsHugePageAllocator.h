@@ -0,0 +1,403 @@
+#ifndef NS_HUGE_PAGE_ALLOCATOR_H
+#define	NS_HUGE_PAGE_ALLOCATOR_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for bad_alloc
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#elif defined(_MSC_VER)
+// for _aligned_malloc()
+#include <malloc.h>
+#endif
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+
+namespace NsLib
+{
+
+/*!
+ * \brief   HugePageAllocator实际得到的页类型。
+ * \ingroup NsPool
+ */
+namespace HugePageType
+{
+
+enum HugePageTypes
+{
+    Heap        = 0,    // 平台不支持mmap, 使用malloc()
+    Normal,             // 普通页
+    Transparent,        // 透明大页, madvise(MADV_HUGEPAGE)成功, 由内核决定是否合并
+    Explicit,           // MAP_HUGETLB分配的大页
+    TypeCount
+};
+
+}   // HugePageType
+
+/*!
+ * \class   HugePageAllocator NsPool.h
+ * \brief   使用mmap分配内存的分配器，大块内存优先使用大页，用于减少TLB miss。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - 要分配内存的数据类型
+ *
+ * \details 与UserDefaultAllocator接口相同，可以直接作为ObjectPool,
+ *          INewFromObjectPool等的Allocator参数。\n
+ *          请求大小不小于一个大页时，首先尝试MAP_HUGETLB；
+ *          失败时(如系统没有预留大页)改为按大页对齐的普通mmap，
+ *          并通过madvise(MADV_HUGEPAGE)请求透明大页；
+ *          更小的请求直接使用普通页。\n
+ *          每次分配在返回地址之前保存映射的大小和页类型，
+ *          这块信息优先放在按页取整后多出的空间里，
+ *          返回地址因此向映射末尾偏移，只有空间不足64字节时才多映射一页。\n
+ *          可通过getPageType()和getPageSize()查询实际得到的页，
+ *          也可通过getMappedSize()查询各类页的映射总量。
+ *
+ * \note    非Linux平台退化为64字节对齐的堆内存，页类型为HugePageType::Heap。\n
+ *          DataType的对齐要求不能超过64字节。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_OBJECT_POOL_NAME(TransformPool,
+ *                            Transform,
+ *                            200000,
+ *                            ::NsLib::HugePageAllocator);
+ *
+ * NS_CREATE_OBJECT_POOL(TransformPool);
+ *
+ * size_t hugePageBytes = ::NsLib::HugePageAllocator<Transform>::getMappedSize(
+ *                            ::NsLib::HugePageType::Explicit);
+ * \endcode
+ *
+ * \see     UserDefaultAllocator
+ */
+template <typename DataType>
+class HugePageAllocator
+{
+    MAKE_CLASS_UNCOPYABLE(HugePageAllocator);
+
+    // 保存在返回地址之前, 占用一个cache line, 使返回地址保持64字节对齐
+    struct MappingHeader
+    {
+        void            *mappingPtr_;
+        size_t          mappingSize_;
+        size_t          pageType_;
+    };
+
+    static const size_t headerSize_ = 64;
+
+    static_assert(sizeof(MappingHeader) <= headerSize_,
+                  "-- MappingHeader must fit in one cache line");
+    static_assert(alignof(DataType) <= headerSize_,
+                  "-- alignment of DataType must not exceed 64 bytes");
+
+public:
+    /*!
+     * \brief   分配大小为size的内存块
+     *
+     * \param   size - 要分配内存块的大小
+     *
+     * \return  分配内存块的首地址
+     *
+     * \throw   bad_alloc
+     */
+    static DataType *allocate(size_t size) NS_THROW(std::bad_alloc)
+    {
+        MappingHeader header;
+
+        mapMemory(size, header);
+        getMappedSizes()[header.pageType_] += header.mappingSize_;
+
+        // 数据放在映射的末尾, header使用取整后剩余的空间
+        DataType *memPtr = (DataType *)(
+            (char *)(header.mappingPtr_)
+            + ((header.mappingSize_ - size) & ~(headerSize_ - 1)));
+
+        ::new(getHeader(memPtr)) MappingHeader(header);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("HugePageAllocator<",
+                        typeid(DataType).name(),
+                        ">::allocate()",
+                        memPtr);
+#endif
+
+        return memPtr;
+    }
+
+    /*!
+     * \brief   释放分配的内存块
+     *
+     * \param   ptr - 要释放内存块的首地址
+     *
+     * \return  无
+     */
+    static void deallocate(DataType *ptr)
+    {
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("HugePageAllocator<",
+                        typeid(DataType).name(),
+                        ">::deallocate()",
+                        ptr);
+#endif
+
+        MappingHeader header = *getHeader(ptr);
+
+        getMappedSizes()[header.pageType_] -= header.mappingSize_;
+
+#if defined(__linux__)
+        munmap(header.mappingPtr_, header.mappingSize_);
+#elif defined(_MSC_VER)
+        _aligned_free(header.mappingPtr_);
+#else
+        free(header.mappingPtr_);
+#endif
+    }
+
+    /*!
+     * \brief   获得ptr所在映射实际使用的页类型。
+     *
+     * \param   ptr - allocate()返回的地址
+     */
+    static ::NsLib::HugePageType::HugePageTypes getPageType(const DataType *ptr)
+    {
+        return (::NsLib::HugePageType::HugePageTypes)(
+            getHeader(ptr)->pageType_);
+    }
+
+    /*!
+     * \brief   获得ptr所在映射实际使用的页大小。
+     *
+     * \note    透明大页返回大页大小，但内核可能只合并了其中的一部分。
+     */
+    static size_t getPageSize(const DataType *ptr)
+    {
+        switch (getPageType(ptr))
+        {
+        case ::NsLib::HugePageType::Explicit:
+        case ::NsLib::HugePageType::Transparent:
+            return getHugePageSize();
+
+        case ::NsLib::HugePageType::Normal:
+            return getNormalPageSize();
+
+        default:
+            return 0;
+        }
+    }
+
+    /*!
+     * \brief   获得当前以pageType映射的内存总字节数。
+     */
+    static size_t getMappedSize(::NsLib::HugePageType::HugePageTypes pageType)
+    {
+        return getMappedSizes()[pageType].load(std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief   获得系统的大页大小，读取/proc/meminfo失败时为2MB。
+     */
+    static size_t getHugePageSize()
+    {
+        static const size_t hugePageSize = readHugePageSize();
+
+        return hugePageSize;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    static MappingHeader *getHeader(const DataType *ptr)
+    {
+        return (MappingHeader *)((char *)(ptr) - headerSize_);
+    }
+
+    static std::atomic<size_t> *getMappedSizes()
+    {
+        static std::atomic<size_t>
+            mappedSizes[::NsLib::HugePageType::TypeCount] = {};
+
+        return mappedSizes;
+    }
+
+    static size_t getNormalPageSize()
+    {
+#if defined(__linux__)
+        static const size_t pageSize = (size_t)(sysconf(_SC_PAGESIZE));
+
+        return pageSize;
+#else
+        return 0;
+#endif
+    }
+
+    static size_t readHugePageSize()
+    {
+        size_t hugePageSize = 2 * 1024 * 1024;
+
+#if defined(__linux__)
+        FILE *meminfo = fopen("/proc/meminfo", "r");
+
+        if (nullptr != meminfo)
+        {
+            char line[128];
+            unsigned long sizeInKb;
+
+            while (nullptr != fgets(line, sizeof(line), meminfo))
+            {
+                if (1 == sscanf(line, "Hugepagesize: %lu kB", &sizeInKb))
+                {
+                    hugePageSize = (size_t)(sizeInKb) * 1024;
+                    break;
+                }
+            }
+
+            fclose(meminfo);
+        }
+#endif
+
+        return hugePageSize;
+    }
+
+    static size_t roundUp(size_t size, size_t alignment)
+    {
+        return (size + alignment - 1) & ~(alignment - 1);
+    }
+
+    // 按页取整后剩余的空间能放下header时不再多映射一页
+    static size_t getMappingSize(size_t size, size_t pageSize)
+    {
+        size_t mappingSize = roundUp(size, pageSize);
+
+        if (mappingSize - size < headerSize_)
+        {
+            mappingSize = roundUp(size + headerSize_, pageSize);
+        }
+
+        return mappingSize;
+    }
+
+    static void mapMemory(size_t size, MappingHeader &header)
+        NS_THROW(std::bad_alloc)
+    {
+#if defined(__linux__)
+        size_t hugePageSize = getHugePageSize();
+
+        if (size < hugePageSize)
+        {
+            header.mappingSize_ = getMappingSize(size, getNormalPageSize());
+            header.mappingPtr_ = mmap(nullptr,
+                                      header.mappingSize_,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS,
+                                      -1,
+                                      0);
+            header.pageType_ = ::NsLib::HugePageType::Normal;
+        }
+        else
+        {
+            header.mappingSize_ = getMappingSize(size, hugePageSize);
+            header.mappingPtr_ = mmap(nullptr,
+                                      header.mappingSize_,
+                                      PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                                      -1,
+                                      0);
+            header.pageType_ = ::NsLib::HugePageType::Explicit;
+
+            if (MAP_FAILED == header.mappingPtr_)
+            {
+                mapTransparent(header);
+            }
+        }
+
+        if (MAP_FAILED == header.mappingPtr_)
+        {
+            throw std::bad_alloc();
+        }
+#else
+        header.mappingSize_ = getMappingSize(size, headerSize_);
+        header.pageType_ = ::NsLib::HugePageType::Heap;
+
+#if defined(_MSC_VER)
+        header.mappingPtr_ = _aligned_malloc(header.mappingSize_, headerSize_);
+#else
+        if (0 != posix_memalign(&header.mappingPtr_,
+                                headerSize_,
+                                header.mappingSize_))
+        {
+            header.mappingPtr_ = nullptr;
+        }
+#endif
+
+        if (nullptr == header.mappingPtr_)
+        {
+            throw std::bad_alloc();
+        }
+#endif
+    }
+
+#if defined(__linux__)
+    // 多映射一个大页, 再切掉首尾, 得到按大页对齐的区域, 透明大页才能生效
+    static void mapTransparent(MappingHeader &header)
+    {
+        size_t hugePageSize = getHugePageSize();
+        char *memPtr = (char *)(mmap(nullptr,
+                                     header.mappingSize_ + hugePageSize,
+                                     PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS,
+                                     -1,
+                                     0));
+
+        if (MAP_FAILED == (void *)(memPtr))
+        {
+            header.mappingPtr_ = MAP_FAILED;
+            return;
+        }
+
+        char *alignedPtr = (char *)(roundUp((uintptr_t)(memPtr), hugePageSize));
+        size_t headSlop = alignedPtr - memPtr;
+        size_t tailSlop = hugePageSize - headSlop;
+
+        if (0 != headSlop)
+        {
+            munmap(memPtr, headSlop);
+        }
+
+        if (0 != tailSlop)
+        {
+            munmap(alignedPtr + header.mappingSize_, tailSlop);
+        }
+
+        header.mappingPtr_ = alignedPtr;
+
+#ifdef MADV_HUGEPAGE
+        header.pageType_ = 0 == madvise(alignedPtr,
+                                        header.mappingSize_,
+                                        MADV_HUGEPAGE)
+                           ? ::NsLib::HugePageType::Transparent
+                           : ::NsLib::HugePageType::Normal;
+#else
+        header.pageType_ = ::NsLib::HugePageType::Normal;
+#endif
+    }
+#endif
+};
+
+}   // NsLib
+
+#endif
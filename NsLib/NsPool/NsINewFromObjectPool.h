@@ -18,6 +18,10 @@ namespace NsLib
  * \details 本Object Pool默认容量为1000，超出1000在debug模式下会触发断言。\n
  *          默认使用的是UserDefaultAllocator内存分配器，如果对内存分配有特殊需求，
  *          请根据UserDefaultAllocator接口自定义内存分配器。\n
+ *          operator delete带有对象大小参数，比DataType大的对象(没有自己Pool的派生类)
+ *          由operator new从堆上分配，删除时根据大小直接判断，不需要比较地址。\n
+ *          new DataType[n]在Pool中没有回收过的块时，从未分配区域中划出相邻的块，
+ *          否则使用::operator new；delete[]根据地址判断归还给哪一方。
  *
  * \code
  * // 示例：
@@ -122,7 +126,9 @@ namespace NsLib
  *
  * \endcode
  *
- * \note    默认内存配置器接口。
+ * \note    默认内存配置器接口。\n
+ *          Pool中有数组时，请不要对它调用compact()、resetAndDestroyObjects()
+ *          和forEachLive()，见LocalObjectPool::getContiguousMemory()。
  *
  * \see     UserDefaultAllocator
  */
@@ -134,6 +140,8 @@ class INewFromObjectPool
 {
     friend class ::NsLib::ObjectPool<DataType, capacity, Allocator>;
 
+    typedef ::NsLib::ObjectPool<DataType, capacity, Allocator> PoolName_;
+
 public:
     void *operator new(size_t size)
     {
@@ -141,18 +149,57 @@ public:
         NS_TRACE_NEW_FROM_OBJECT_POOL(DataType);
 #endif
 
-        return ::NsLib::ObjectPool<DataType, capacity, Allocator>
-               ::getObjectMemory();
+        // 没有自己Pool的派生类比块大, 只能从堆上分配
+        if (sizeof(DataType) < size)
+        {
+            return ::operator new(size);
+        }
+
+        return PoolName_::getObjectMemory();
+    }
+
+    // 编译器传入的是对象的实际大小, 不需要比较地址就能知道内存来自哪里
+    void operator delete(void *ptr, size_t size)
+    {
+#ifdef _NS_DEBUG_TRACE_NEW_AND_DELETE_FROM_OBJECT_POOL_
+        NS_TRACE_DELETE_FROM_OBJECT_POOL(DataType);
+#endif
+
+        if (sizeof(DataType) < size)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        PoolName_::deallocateMemory(static_cast<DataType *>(ptr));
+    }
+
+    void *operator new[](size_t size)
+    {
+#ifdef _NS_DEBUG_TRACE_NEW_AND_DELETE_FROM_OBJECT_POOL_
+        NS_TRACE_NEW_FROM_OBJECT_POOL(DataType);
+#endif
+
+        void *memPtr = PoolName_::getContiguousMemory(size);
+
+        return nullptr != memPtr ? memPtr : ::operator new(size);
     }
 
-    void operator delete(void *ptr)
+    // size与operator new[]收到的相同, 包括编译器保存元素个数所用的空间
+    void operator delete[](void *ptr, size_t size)
     {
 #ifdef _NS_DEBUG_TRACE_NEW_AND_DELETE_FROM_OBJECT_POOL_
         NS_TRACE_DELETE_FROM_OBJECT_POOL(DataType);
 #endif
 
-        ::NsLib::ObjectPool<DataType, capacity, Allocator>
-               ::deallocateMemory(static_cast<DataType *>(ptr));
+        if (PoolName_::isPointerValid(static_cast<DataType *>(ptr)))
+        {
+            PoolName_::deallocateContiguousMemory(ptr, size);
+        }
+        else
+        {
+            ::operator delete(ptr);
+        }
     }
 };
 
@@ -315,7 +362,9 @@ public:
  */
 #define NS_INTRUSIVE_OBJECT_POOL_MULTI_INHERIT(...)                            \
     using ::NsLib::INewFromObjectPool<__VA_ARGS__>::operator new;              \
-    using ::NsLib::INewFromObjectPool<__VA_ARGS__>::operator delete
+    using ::NsLib::INewFromObjectPool<__VA_ARGS__>::operator delete;           \
+    using ::NsLib::INewFromObjectPool<__VA_ARGS__>::operator new[];            \
+    using ::NsLib::INewFromObjectPool<__VA_ARGS__>::operator delete[]
 } // NsLib
 
 #endif
@@ -0,0 +1,419 @@
+#ifndef NS_MEMORY_POOL_H
+#define	NS_MEMORY_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstdint>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \internal
+ * \brief   Memory Pool的尺寸分级表。
+ *
+ * \details 8 ~ 64字节按8字节分级，64 ~ 4096字节每个2的幂之间再分为两级，
+ *          任意请求的内部浪费不超过50%，绝大多数不超过33%。
+ * \endinternal
+ */
+namespace MemoryPoolSizeClass
+{
+
+static const size_t classSizes_[] =
+{
+    8,      16,     24,     32,     40,     48,     56,     64,
+    96,     128,    192,    256,    384,    512,    768,    1024,
+    1536,   2048,   3072,   4096
+};
+
+enum SizeClassLimits
+{
+    Granularity     = 8,
+    MaxSize         = 4096,
+    ClassCount      = sizeof(classSizes_) / sizeof(classSizes_[0])
+};
+
+}   // MemoryPoolSizeClass
+
+/*!
+ * \class   MemoryPool NsPool.h
+ * \brief   按尺寸分级的通用Memory Pool，用于字符串、网络包等变长数据。
+ * \ingroup NsPool
+ *
+ * \tparam  [可选]size_t slabSize - 每个slab中可供分配的字节数[默认 = 64KB]
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 每个尺寸等级维护一个与ObjectPool相同的空闲链表，
+ *          链表为空时从当前slab的未分配区域中顺序划出，
+ *          slab用尽时再向Allocator申请新的slab。\n
+ *          超过4096字节的请求直接交给Allocator。\n
+ *          所有slab只在destroy()时释放，期间不会向系统归还内存，
+ *          因此不会在长时间运行后产生堆碎片。
+ *
+ * \note    释放时必须给出与分配时相同的size，这样就不需要在每个块前保存头部信息。\n
+ *          不是线程安全的，多线程条件下请自行加锁。\n
+ *          所有块按8字节对齐，超过8字节的对齐要求请使用ObjectPool。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_MEMORY_POOL_NAME(PacketMemoryPool);
+ *
+ * NS_CREATE_MEMORY_POOL(PacketMemoryPool);
+ *
+ * char *payload = static_cast<char *>(PacketMemoryPool::allocate(length));
+ * // ...
+ * PacketMemoryPool::deallocate(payload, length);
+ *
+ * NS_DESTROY_MEMORY_POOL(PacketMemoryPool);
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <size_t    slabSize = 64 * 1024,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class MemoryPool
+{
+    MAKE_CLASS_UNCOPYABLE(MemoryPool);
+
+    static_assert(::NsLib::MemoryPoolSizeClass::MaxSize <= slabSize,
+                  "-- slabSize must hold at least one block of each class");
+
+    typedef Allocator<char> PoolAllocator;
+
+    struct FreeBlockNode
+    {
+        FreeBlockNode   *pNext_;
+    };
+
+    // 保存在每个slab实际分配内存的开头, 用于destroy()时释放
+    struct SlabHeader
+    {
+        SlabHeader      *pNext_;
+    };
+
+    // slab头部和对齐所需的额外空间, 不计入slabSize
+    static const size_t slabOverhead_ =
+        sizeof(SlabHeader) + ::NsLib::MemoryPoolSizeClass::Granularity - 1;
+
+    enum
+    {
+        LookupSize = ::NsLib::MemoryPoolSizeClass::MaxSize
+                     / ::NsLib::MemoryPoolSizeClass::Granularity + 1
+    };
+
+public:
+    ~MemoryPool()
+    {
+        if (!isDestroyed())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建Memory Pool，申请第一个slab。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!getInstance().isCreated()
+               && "-- you have already create the memory pool");
+
+        getInstance().init();
+    }
+
+    /*!
+     * \brief   销毁Memory Pool，释放所有slab。
+     *
+     * \note    大于4096字节的块不受Memory Pool管理，需要在此之前自行释放。
+     */
+    static void destroy()
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a memory pool");
+
+        SlabHeader *slab = getInstance().firstSlab_;
+
+        while (nullptr != slab)
+        {
+            SlabHeader *next = slab->pNext_;
+
+            PoolAllocator::deallocate((char *)(slab));
+            slab = next;
+        }
+
+        getInstance().firstSlab_ = nullptr;
+    }
+
+    /*!
+     * \brief   分配至少size字节的内存。
+     *
+     * \param   size - 要分配的字节数
+     *
+     * \return  内存块首地址
+     *
+     * \throw   bad_alloc
+     */
+    static void *allocate(size_t size) NS_THROW(std::bad_alloc)
+    {
+        assert(getInstance().isCreated()
+               && "-- you have not create a memory pool");
+
+        if (::NsLib::MemoryPoolSizeClass::MaxSize < size)
+        {
+            return PoolAllocator::allocate(size);
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        void *ptr = getInstance().getMemoryBlock(getSizeClass(size));
+
+        NS_TRACE_MEMORY("MemoryPool<",
+                        size,
+                        ">::allocate()",
+                        ptr);
+        return ptr;
+#else
+        return getInstance().getMemoryBlock(getSizeClass(size));
+#endif
+    }
+
+    /*!
+     * \brief   释放allocate()分配的内存。
+     *
+     * \param   ptr - 内存块首地址，允许为nullptr
+     * \param   size - 分配时传入的字节数
+     */
+    static void deallocate(void *ptr, size_t size)
+    {
+        if (nullptr == ptr)
+        {
+            return;
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("MemoryPool<",
+                        size,
+                        ">::deallocate()",
+                        ptr);
+#endif
+
+        if (::NsLib::MemoryPoolSizeClass::MaxSize < size)
+        {
+            PoolAllocator::deallocate(static_cast<char *>(ptr));
+            return;
+        }
+
+        getInstance().returnMemoryBlock(getSizeClass(size),
+                                        static_cast<FreeBlockNode *>(ptr));
+    }
+
+    /*!
+     * \brief   获得size字节的请求实际占用的块大小。
+     */
+    static size_t getBlockSize(size_t size)
+    {
+        if (::NsLib::MemoryPoolSizeClass::MaxSize < size)
+        {
+            return size;
+        }
+
+        return ::NsLib::MemoryPoolSizeClass::classSizes_[getSizeClass(size)];
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    MemoryPool() :
+        firstSlab_{nullptr},
+        slabCurrent_{nullptr},
+        slabEnd_{nullptr}
+    {
+        for (size_t i = 0; i < ::NsLib::MemoryPoolSizeClass::ClassCount; ++i)
+        {
+            firstFreeBlock_[i] = nullptr;
+        }
+    }
+
+    static MemoryPool<slabSize, Allocator> &getInstance()
+    {
+        static MemoryPool<slabSize, Allocator> poolInstance;
+
+        return poolInstance;
+    }
+
+    // (size + 7) / 8 -> 尺寸等级, 只在第一次使用时计算
+    static size_t getSizeClass(size_t size)
+    {
+        static const SizeClassTable table;
+
+        return table.classIndex_[
+            (size + ::NsLib::MemoryPoolSizeClass::Granularity - 1)
+            / ::NsLib::MemoryPoolSizeClass::Granularity];
+    }
+
+    struct SizeClassTable
+    {
+        SizeClassTable()
+        {
+            size_t sizeClass = 0;
+
+            for (size_t i = 0; i < LookupSize; ++i)
+            {
+                while (::NsLib::MemoryPoolSizeClass::classSizes_[sizeClass]
+                       < i * ::NsLib::MemoryPoolSizeClass::Granularity)
+                {
+                    ++sizeClass;
+                }
+
+                classIndex_[i] = (unsigned char)(sizeClass);
+            }
+        }
+
+        unsigned char   classIndex_[LookupSize];
+    };
+
+    void init()
+    {
+        for (size_t i = 0; i < ::NsLib::MemoryPoolSizeClass::ClassCount; ++i)
+        {
+            firstFreeBlock_[i] = nullptr;
+        }
+
+        addSlab();
+    }
+
+    bool isCreated()
+    {
+        return nullptr == firstSlab_ ? false : true;
+    }
+
+    bool isDestroyed()
+    {
+        return nullptr == firstSlab_ ? true : false;
+    }
+
+    void addSlab() NS_THROW(std::bad_alloc)
+    {
+        SlabHeader *slab = (SlabHeader *)(
+            PoolAllocator::allocate(slabOverhead_ + slabSize));
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("MemoryPool<",
+                        slabSize,
+                        ">::addSlab() slab",
+                        slab);
+#endif
+
+        slab->pNext_ = firstSlab_;
+        firstSlab_ = slab;
+
+        // 块按Granularity对齐, SlabHeader之后的剩余空间作为未分配区域
+        slabCurrent_ = (char *)(
+            ((uintptr_t)(slab + 1)
+             + ::NsLib::MemoryPoolSizeClass::Granularity - 1)
+            & (uintptr_t)(~(::NsLib::MemoryPoolSizeClass::Granularity - 1)));
+        slabEnd_ = slabCurrent_ + slabSize;
+    }
+
+    void *getMemoryBlock(size_t sizeClass)
+    {
+        FreeBlockNode *object = firstFreeBlock_[sizeClass];
+
+        if (nullptr != object)
+        {
+            firstFreeBlock_[sizeClass] = object->pNext_;
+
+            return object;
+        }
+
+        size_t blockSize = ::NsLib::MemoryPoolSizeClass::classSizes_[sizeClass];
+
+        // 当前slab剩余空间不足时放弃剩余部分, 最多浪费一个最大块的大小
+        if ((size_t)(slabEnd_ - slabCurrent_) < blockSize)
+        {
+            addSlab();
+        }
+
+        void *ptr = slabCurrent_;
+
+        slabCurrent_ += blockSize;
+
+        return ptr;
+    }
+
+    void returnMemoryBlock(size_t sizeClass, FreeBlockNode *objectBlock)
+    {
+        objectBlock->pNext_ = firstFreeBlock_[sizeClass];
+        firstFreeBlock_[sizeClass] = objectBlock;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    SlabHeader      *firstSlab_;        // slab链表, 用于释放
+    char            *slabCurrent_;      // 当前slab中未分配区域的首地址
+    char            *slabEnd_;          // 当前slab的末尾
+    FreeBlockNode   *firstFreeBlock_[::NsLib::MemoryPoolSizeClass::ClassCount];
+};
+
+/*!
+ * \brief   定义Memory Pool的名字。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - MemoryPool名称
+ * \param   [可选]slab大小[默认=64KB]
+ * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ *
+ * \see     NS_CREATE_MEMORY_POOL   \n
+ *          NS_DESTROY_MEMORY_POOL
+ */
+#define NS_DEFINE_MEMORY_POOL_NAME(PoolName, ...) \
+    typedef ::NsLib::MemoryPool<__VA_ARGS__> PoolName
+
+/*!
+ * \brief   创建Memory Pool。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - MemoryPool名称
+ *
+ * \note    Debug模式下重复创建同一个Memory Pool会触发断言。
+ *
+ * \see     NS_DEFINE_MEMORY_POOL_NAME
+ */
+#define NS_CREATE_MEMORY_POOL(PoolName) \
+    PoolName::create()
+
+/*!
+ * \brief   销毁Memory Pool。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - MemoryPool名称
+ *
+ * \see     NS_DEFINE_MEMORY_POOL_NAME
+ */
+#define NS_DESTROY_MEMORY_POOL(PoolName) \
+    PoolName::destroy()
+
+}   // NsLib
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef NS_MEMORY_RESOURCE_H
+#define	NS_MEMORY_RESOURCE_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// std::pmr需要C++17以及<memory_resource>
+#if __cplusplus >= 201703L && defined(__has_include)
+    #if __has_include(<memory_resource>)
+        #define NS_MEMORY_RESOURCE_SUPPORT
+    #endif
+#endif
+
+#ifdef NS_MEMORY_RESOURCE_SUPPORT
+
+// for assert()
+#include <cassert>
+// for bad_alloc
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <memory_resource>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   ObjectPoolResource NsPool.h
+ * \brief   以ObjectPool的空闲链表实现的std::pmr::memory_resource，
+ *          所有块大小相同。
+ * \ingroup NsPool
+ *
+ * \tparam  size_t blockSize - 每个块的字节数
+ * \tparam  [可选]size_t capacity - 块的个数[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 不超过blockSize字节且对齐要求不超过alignof(max_align_t)的请求
+ *          从内部的LocalObjectPool中分配，其余请求以及Pool已满时交给upstream。\n
+ *          适合std::pmr::list, std::pmr::map, std::pmr::unordered_map的结点，
+ *          std::pmr::vector等连续容器的大块请求会直接交给upstream。
+ *
+ * \note    不是线程安全的。\n
+ *          resource必须比使用它的所有容器存活得更久。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::ObjectPoolResource<64, 100000> sessionResource;
+ *
+ * std::pmr::unordered_map<int, Session> sessions{&sessionResource};
+ * \endcode
+ *
+ * \see     LocalObjectPool \n
+ *          MonotonicPoolResource
+ */
+template <size_t    blockSize,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class ObjectPoolResource : public std::pmr::memory_resource
+{
+    MAKE_CLASS_UNCOPYABLE(ObjectPoolResource);
+
+    typedef typename std::aligned_storage<blockSize,
+                                          alignof(std::max_align_t)>::type
+            Block;
+
+    typedef ::NsLib::LocalObjectPool<Block, capacity, Allocator> PoolInstance;
+
+public:
+    /*!
+     * \brief   创建resource，同时创建内部的Pool。
+     *
+     * \param   [可选]upstream - 无法由Pool满足的请求交给它[默认 = get_default_resource()]
+     *
+     * \throw   bad_alloc
+     */
+    explicit ObjectPoolResource(
+        std::pmr::memory_resource *upstream = std::pmr::get_default_resource())
+        : upstream_{upstream}
+    {
+        pool_.create();
+    }
+
+    std::pmr::memory_resource *getUpstream() const
+    {
+        return upstream_;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (bytes <= sizeof(Block)
+            && alignment <= alignof(Block)
+            && pool_.hasFreeBlock())
+        {
+            return pool_.getObjectMemory();
+        }
+
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment) override
+    {
+        if (pool_.isPointerValid(static_cast<Block *>(ptr)))
+        {
+            pool_.deallocateMemory(static_cast<Block *>(ptr));
+        }
+        else
+        {
+            upstream_->deallocate(ptr, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override
+    {
+        return this == &other;
+    }
+
+    PoolInstance                pool_;
+    std::pmr::memory_resource   *upstream_;
+};
+
+/*!
+ * \class   MonotonicPoolResource NsPool.h
+ * \brief   只分配不释放的std::pmr::memory_resource，内存来自Allocator。
+ * \ingroup NsPool
+ *
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 每次分配只在当前chunk中移动指针，deallocate()不做任何事情；
+ *          chunk用尽时向Allocator申请一个更大的chunk(每次翻倍)。\n
+ *          release()或析构时一次释放所有chunk。\n
+ *          适合生命周期一致的临时数据，如一次请求、一帧内构建的容器。
+ *
+ * \note    不是线程安全的。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::MonotonicPoolResource<> requestResource(64 * 1024);
+ *
+ * std::pmr::vector<Item> items{&requestResource};
+ * std::pmr::string name{&requestResource};
+ *
+ * // ...
+ *
+ * requestResource.release();
+ * \endcode
+ *
+ * \see     ObjectPoolResource \n
+ *          FrameArena
+ */
+template <template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class MonotonicPoolResource : public std::pmr::memory_resource
+{
+    MAKE_CLASS_UNCOPYABLE(MonotonicPoolResource);
+
+    typedef Allocator<char> ResourceAllocator;
+
+    // 保存在每个chunk的开头, 用于release()时释放
+    struct alignas(std::max_align_t) ChunkHeader
+    {
+        ChunkHeader     *pNext_;
+        size_t          size_;
+    };
+
+public:
+    /*!
+     * \param   [可选]initialSize - 第一个chunk的字节数[默认 = 4KB]
+     */
+    explicit MonotonicPoolResource(size_t initialSize = 4 * 1024) :
+        nextChunkSize_{initialSize},
+        firstChunk_{nullptr},
+        current_{nullptr},
+        end_{nullptr}
+    {
+        assert(0 < initialSize && "-- initialSize must be greater than 0");
+    }
+
+    ~MonotonicPoolResource()
+    {
+        release();
+    }
+
+    /*!
+     * \brief   释放所有chunk，之前分配的所有内存都将失效。
+     */
+    void release()
+    {
+        ChunkHeader *chunk = firstChunk_;
+
+        while (nullptr != chunk)
+        {
+            ChunkHeader *next = chunk->pNext_;
+
+            ResourceAllocator::deallocate((char *)(chunk));
+            chunk = next;
+        }
+
+        firstChunk_ = nullptr;
+        current_ = nullptr;
+        end_ = nullptr;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        char *memPtr = alignUp(current_, alignment);
+
+        if (nullptr == current_ || memPtr > end_
+            || (size_t)(end_ - memPtr) < bytes)
+        {
+            addChunk(bytes + alignment);
+            memPtr = alignUp(current_, alignment);
+        }
+
+        current_ = memPtr + bytes;
+
+        return memPtr;
+    }
+
+    void do_deallocate(void *, size_t, size_t) override
+    {
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override
+    {
+        return this == &other;
+    }
+
+    static char *alignUp(char *ptr, size_t alignment)
+    {
+        return (char *)(((uintptr_t)(ptr) + alignment - 1)
+                        & (uintptr_t)(~(alignment - 1)));
+    }
+
+    void addChunk(size_t minSize) NS_THROW(std::bad_alloc)
+    {
+        while (nextChunkSize_ < minSize)
+        {
+            nextChunkSize_ *= 2;
+        }
+
+        ChunkHeader *chunk = (ChunkHeader *)(
+            ResourceAllocator::allocate(sizeof(ChunkHeader) + nextChunkSize_));
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("MonotonicPoolResource<",
+                        nextChunkSize_,
+                        ">::addChunk() chunk",
+                        chunk);
+#endif
+
+        chunk->pNext_ = firstChunk_;
+        chunk->size_ = nextChunkSize_;
+        firstChunk_ = chunk;
+
+        current_ = (char *)(chunk + 1);
+        end_ = current_ + nextChunkSize_;
+
+        nextChunkSize_ *= 2;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    size_t          nextChunkSize_;     // 下一个chunk的字节数
+    ChunkHeader     *firstChunk_;       // chunk链表, 用于释放
+    char            *current_;          // 当前chunk中未分配区域的首地址
+    char            *end_;              // 当前chunk的末尾
+};
+
+}   // NsLib
+
+#endif  // NS_MEMORY_RESOURCE_SUPPORT
+
+#endif
@@ -0,0 +1,487 @@
+#ifndef NS_NUMA_OBJECT_POOL_H
+#define	NS_NUMA_OBJECT_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for bad_alloc
+#include <new>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "../NsSynchronization/NsLock.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \internal
+ * \brief   读取NUMA拓扑，并将内存绑定到指定结点。
+ *
+ * \details 结点和CPU的信息来自/sys/devices/system/node，
+ *          绑定使用mbind系统调用，不依赖libnuma。
+ * \endinternal
+ */
+class NumaTopology
+{
+    // 与<numaif.h>中的定义相同
+    static const int mpolPreferred_ = 1;
+    static const unsigned int mpolMfMove_ = 1 << 1;
+
+public:
+    // nodeIds[i]为第i个在线结点的编号, 编号可能不连续(如"0,2");
+    // 读取失败或非Linux平台只有结点0
+    static void readNodeIds(std::vector<uint16_t> &nodeIds)
+    {
+        nodeIds.clear();
+
+        readList("/sys/devices/system/node/online", [&](size_t node)
+        {
+            nodeIds.push_back((uint16_t)(node));
+        });
+
+        if (nodeIds.empty())
+        {
+            nodeIds.push_back(0);
+        }
+    }
+
+    // cpuToNode[cpu]为cpu所在结点在nodeIds中的下标,
+    // 下标不小于usedNodeCount的结点折回到[0, usedNodeCount)
+    static void readCpuToNode(const std::vector<uint16_t> &nodeIds,
+                              size_t usedNodeCount,
+                              std::vector<uint16_t> &cpuToNode)
+    {
+        cpuToNode.clear();
+
+        for (size_t node = 0; 1 < usedNodeCount && node < nodeIds.size(); ++node)
+        {
+            char fileName[64];
+
+            snprintf(fileName, sizeof(fileName),
+                     "/sys/devices/system/node/node%u/cpulist",
+                     (unsigned int)(nodeIds[node]));
+
+            readList(fileName, [&](size_t cpu)
+            {
+                if (cpuToNode.size() <= cpu)
+                {
+                    cpuToNode.resize(cpu + 1, 0);
+                }
+
+                cpuToNode[cpu] = (uint16_t)(node % usedNodeCount);
+            });
+        }
+    }
+
+    static size_t getCurrentCpu()
+    {
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+
+        return cpu < 0 ? 0 : (size_t)(cpu);
+#else
+        return 0;
+#endif
+    }
+
+    /*!
+     * \brief   将[memPtr, memPtr + size)中完整的页优先放在node上，
+     *          已经分配的页会被迁移过去。
+     *
+     * \param   node - 系统中的结点编号，而不是NumaObjectPool中的下标
+     *
+     * \return  内核不支持、没有权限或结点编号超出掩码范围时返回false
+     */
+    static bool bindMemory(void *memPtr, size_t size, size_t node)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        size_t pageSize = (size_t)(sysconf(_SC_PAGESIZE));
+        uintptr_t first = ((uintptr_t)(memPtr) + pageSize - 1)
+                          & ~(uintptr_t)(pageSize - 1);
+        uintptr_t last = ((uintptr_t)(memPtr) + size)
+                         & ~(uintptr_t)(pageSize - 1);
+        unsigned long nodeMask;
+
+        if (last <= first || sizeof(nodeMask) * 8 <= node)
+        {
+            return false;
+        }
+
+        nodeMask = 1ul << node;
+
+        // 内核会先将maxnode减一
+        return 0 == syscall(SYS_mbind,
+                            (void *)(first),
+                            (unsigned long)(last - first),
+                            mpolPreferred_,
+                            &nodeMask,
+                            (unsigned long)(sizeof(nodeMask) * 8 + 1),
+                            mpolMfMove_);
+#else
+        (void)(memPtr);
+        (void)(size);
+        (void)(node);
+
+        return false;
+#endif
+    }
+
+private:
+    // 解析"0-3,8,10-11"格式的列表, 对每个编号调用function
+    template <typename Function>
+    static void readList(const char *fileName, Function function)
+    {
+#if defined(__linux__)
+        FILE *file = fopen(fileName, "r");
+
+        if (nullptr == file)
+        {
+            return;
+        }
+
+        unsigned long first;
+        unsigned long last;
+        char separator;
+
+        while (1 == fscanf(file, "%lu", &first))
+        {
+            last = first;
+            separator = (char)(fgetc(file));
+
+            if ('-' == separator)
+            {
+                if (1 != fscanf(file, "%lu", &last))
+                {
+                    break;
+                }
+
+                separator = (char)(fgetc(file));
+            }
+
+            for (unsigned long id = first; id <= last; ++id)
+            {
+                function((size_t)(id));
+            }
+
+            if (',' != separator)
+            {
+                break;
+            }
+        }
+
+        fclose(file);
+#else
+        (void)(fileName);
+        (void)(function);
+#endif
+    }
+};
+
+/*!
+ * \class   NumaObjectPool NsPool.h
+ * \brief   每个NUMA结点一个Object Pool，对象从调用线程所在结点的内存中分配。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacityPerNode - 每个结点的容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ * \tparam  [可选]size_t maxNodeCount - 最多使用的结点数[默认 = 8]
+ * \tparam  [可选]LockProxy - 保护每个结点Pool的锁类型[默认 = NsLcok]
+ *
+ * \details create()时读取系统的在线结点，为每个结点创建一个LocalObjectPool，
+ *          并用mbind()将它的内存优先放在该结点上；
+ *          这样无论哪个线程第一次访问，页都会分配在正确的结点。\n
+ *          getObjectMemory()通过sched_getcpu()找到调用线程所在的结点，
+ *          从该结点的Pool中分配，该结点已满时依次尝试其他结点。\n
+ *          deleteObject()根据地址将块归还给分配它的结点，可以在任意线程中调用。\n
+ *          每个结点有独立的锁，不同结点上的线程之间没有争用。\n
+ *          结点编号可以不连续，Pool按在线结点的顺序编号，
+ *          getCurrentNode()和getNodeOf()返回的都是这个下标。
+ *
+ * \note    单结点的机器上只有一个Pool，不调用mbind()，行为与加锁的ObjectPool相同。\n
+ *          mbind()失败时(如容器禁止了该系统调用)，页会分配在第一次访问它的线程所在的结点，
+ *          由于分配本身已按结点路由，大多数情况下仍然是本地内存，
+ *          可通过isMemoryBound()查询。\n
+ *          结点数超过maxNodeCount时，多出的结点共用前面的Pool。\n
+ *          create()和destroy()不是线程安全的，请在工作线程启动前创建，
+ *          在所有工作线程结束后销毁。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_NUMA_OBJECT_POOL_NAME(EntityPool, Entity, 100000);
+ *
+ * NS_CREATE_OBJECT_POOL(EntityPool);
+ *
+ * // 在任意工作线程中：
+ * Entity *entity = NS_NEW_FROM_OBJECT_POOL(EntityPool, id);
+ * NS_DELETE_IN_OBJECT_POOL(EntityPool, entity);
+ *
+ * NS_DESTROY_OBJECT_POOL(EntityPool);
+ * \endcode
+ *
+ * \see     LocalObjectPool \n
+ *          ThreadCachedObjectPool
+ */
+template <typename  DataType,
+          size_t    capacityPerNode = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator,
+          size_t    maxNodeCount = 8,
+          typename  LockProxy = ::NsLib::NsLcok>
+class NumaObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(NumaObjectPool);
+
+    static_assert(0 < maxNodeCount && maxNodeCount <= 64,
+                  "-- maxNodeCount must be between 1 and 64");
+
+    typedef ::NsLib::LocalObjectPool<DataType, capacityPerNode, Allocator>
+            NodePoolInstance;
+
+    // 每个结点独占cache line, 避免不同结点的锁互相干扰
+    struct alignas(64) Node
+    {
+        LockProxy           lock_;
+        NodePoolInstance    pool_;
+    };
+
+    struct SharedState
+    {
+        SharedState() : nodeCount_{0}, memoryBound_{false}
+        {
+        }
+
+        Node                    nodes_[maxNodeCount];
+        size_t                  nodeCount_;
+        bool                    memoryBound_;
+        std::vector<uint16_t>   nodeIds_;       // 下标 -> 系统中的结点编号
+        std::vector<uint16_t>   cpuToNode_;     // CPU -> 下标
+    };
+
+public:
+    typedef DataType    DataType_;
+
+    /*!
+     * \brief   读取NUMA拓扑，为每个结点创建Object Pool。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        SharedState &state = getSharedState();
+
+        assert(0 == state.nodeCount_
+               && "-- you have already create the object pool");
+
+        ::NsLib::NumaTopology::readNodeIds(state.nodeIds_);
+
+        size_t nodeCount = state.nodeIds_.size();
+
+        state.nodeCount_ = nodeCount < maxNodeCount ? nodeCount : maxNodeCount;
+        state.memoryBound_ = 1 < state.nodeCount_;
+        ::NsLib::NumaTopology::readCpuToNode(state.nodeIds_,
+                                             state.nodeCount_,
+                                             state.cpuToNode_);
+
+        for (size_t node = 0; node < state.nodeCount_; ++node)
+        {
+            NodePoolInstance &pool = state.nodes_[node].pool_;
+
+            pool.create();
+
+            // 此时只有第一个块所在的页被访问过, 会被一起迁移
+            if (1 < state.nodeCount_
+                && !::NsLib::NumaTopology::bindMemory(
+                        pool.poolMemPtr_,
+                        pool.getPoolMemorySize(),
+                        state.nodeIds_[node]))
+            {
+                state.memoryBound_ = false;
+            }
+        }
+    }
+
+    /*!
+     * \brief   销毁所有结点的Object Pool，并释放所有分配的内存。
+     */
+    static void destroy()
+    {
+        SharedState &state = getSharedState();
+
+        assert(0 != state.nodeCount_
+               && "-- you have not create a object pool");
+
+        for (size_t node = 0; node < state.nodeCount_; ++node)
+        {
+            state.nodes_[node].pool_.destroy();
+        }
+
+        state.nodeCount_ = 0;
+        state.memoryBound_ = false;
+    }
+
+    /*!
+     * \brief   从调用线程所在结点的Pool中分配一个块。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    所有结点都已满时，Debug模式下会触发断言，Release模式下抛出bad_alloc。
+     */
+    static DataType *getObjectMemory()
+    {
+        SharedState &state = getSharedState();
+
+        assert(0 != state.nodeCount_
+               && "-- you have not create a object pool");
+
+        size_t currentNode = getCurrentNode();
+
+        for (size_t i = 0; i < state.nodeCount_; ++i)
+        {
+            Node &node = state.nodes_[(currentNode + i) % state.nodeCount_];
+            ::NsLib::Lock<LockProxy> lockNode{&node.lock_};
+
+            if (node.pool_.hasFreeBlock())
+            {
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+                DataType *ptr = node.pool_.getObjectMemory();
+
+                NS_TRACE_MEMORY("NumaObjectPool<",
+                                typeid(DataType).name(),
+                                ">::getObjectMemory()",
+                                ptr);
+                return ptr;
+#else
+                return node.pool_.getObjectMemory();
+#endif
+            }
+        }
+
+        assert(false && "-- the object pool has not enough object");
+        throw std::bad_alloc();
+    }
+
+    static void deleteObject(DataType *objectPtr)
+    {
+        assert(nullptr != objectPtr && "-- objectPtr is nullptr");
+
+        objectPtr->~DataType();
+
+        deallocateMemory(objectPtr);
+    }
+
+    static void deallocateMemory(DataType *objectPtr)
+    {
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("NumaObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        Node &node = getSharedState().nodes_[getNodeOf(objectPtr)];
+        ::NsLib::Lock<LockProxy> lockNode{&node.lock_};
+
+        node.pool_.deallocateMemory(objectPtr);
+    }
+
+    /*!
+     * \brief   获得正在使用的结点数，单结点的机器上为1。
+     */
+    static size_t getNodeCount()
+    {
+        return getSharedState().nodeCount_;
+    }
+
+    /*!
+     * \brief   获得调用线程当前所在结点的下标。
+     */
+    static size_t getCurrentNode()
+    {
+        const SharedState &state = getSharedState();
+        size_t cpu = ::NsLib::NumaTopology::getCurrentCpu();
+
+        return cpu < state.cpuToNode_.size() ? state.cpuToNode_[cpu] : 0;
+    }
+
+    /*!
+     * \brief   获得分配objectPtr的结点的下标。
+     */
+    static size_t getNodeOf(DataType *objectPtr)
+    {
+        SharedState &state = getSharedState();
+
+        for (size_t node = 0; node < state.nodeCount_; ++node)
+        {
+            // 各结点Pool的地址范围在create()之后不再改变, 不需要加锁
+            if (state.nodes_[node].pool_.isPointerValid(objectPtr))
+            {
+                return node;
+            }
+        }
+
+        assert(false && "-- the object is not allocated from this object pool");
+        return 0;
+    }
+
+    /*!
+     * \brief   多结点时所有Pool的内存是否都已成功绑定到对应结点。
+     */
+    static bool isMemoryBound()
+    {
+        return getSharedState().memoryBound_;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    NumaObjectPool() = delete;
+
+    static SharedState &getSharedState()
+    {
+        static SharedState sharedState;
+
+        return sharedState;
+    }
+};
+
+/*!
+ * \brief   定义NUMA感知的Object Pool的名字。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   存储的数据类型
+ * \param   [可选]每个结点的容量[默认=1000]
+ * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ * \param   [可选]最多使用的结点数[默认=8]
+ * \param   [可选]锁类型[默认=NsLcok]
+ *
+ * \details 定义后即可使用NS_CREATE_OBJECT_POOL, NS_NEW_FROM_OBJECT_POOL,
+ *          NS_DELETE_IN_OBJECT_POOL, NS_DESTROY_OBJECT_POOL进行操作。
+ *
+ * \see     NumaObjectPool
+ */
+#define NS_DEFINE_NUMA_OBJECT_POOL_NAME(PoolName, ...) \
+    typedef ::NsLib::NumaObjectPool<__VA_ARGS__> PoolName
+
+}   // NsLib
+
+#endif
@@ -9,9 +9,25 @@
 #include <cassert>
 // for placement new and bad_alloc
 #include <new>
+// for memcpy()
+#include <cstring>
 #include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsInternalUse/NsTypeTraits.h"
 #include "../NsUtility/NsUncopyale.h"
 
 namespace NsLib
@@ -20,6 +36,28 @@ namespace NsLib
 // object pool调试用
 //#define _NS_OBJECT_POOL_DEBUG_
 
+template <typename  DataType,
+          size_t    capacity,
+          template  <typename>
+                    class Allocator,
+          size_t    magazineSize,
+          typename  LockProxy>
+class ThreadCachedObjectPool;
+
+template <typename  DataType,
+          size_t    capacityPerNode,
+          template  <typename>
+                    class Allocator,
+          size_t    maxNodeCount,
+          typename  LockProxy>
+class NumaObjectPool;
+
+template <typename  DataType,
+          size_t    capacity,
+          template  <typename>
+                    class Allocator>
+class INewFromObjectPool;
+
 /*!
  * \class   UserDefaultAllocator NsPool.h
  * \brief   Object Pool默认的内存分配器，简单封装了malloc()和free()。
@@ -47,7 +85,7 @@ public:
      *
      * \throw   bad_alloc
      */
-    static DataType *allocate(size_t size) throw (std::bad_alloc)
+    static DataType *allocate(size_t size) NS_THROW(std::bad_alloc)
     {
         DataType *memPtr = static_cast<DataType *>(malloc(size));
 
@@ -91,345 +129,2255 @@ public:
 };
 
 /*!
- * \internal
- * \brief   通用Object Pool。
+ * \brief   将source处的count个对象搬移到destination，搬移后source处的对象已被析构。
  * \ingroup NsPool
  *
- * \tparam  DataType - Object Pool中要存储对象的类型
- * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
- * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
- *
- * \details 本Object Pool默认容量为1000，超出1000在debug模式下会触发断言。\n
- *          默认使用的是UserDefaultAllocator内存分配器，如果对内存分配有特殊需求，
- *          请根据UserDefaultAllocator接口自定义内存分配器。\n
+ * \param   destination - 目标地址，尚未构造对象
+ * \param   source - 源地址
+ * \param   count - 对象个数
  *
- * \note    对于内置数据类型(char ,int, double...)请使用Memory Pool，使用Object Pool
- *          并不能提升效率。
+ * \return  无
  *
- * \note    默认内存配置器接口。
+ * \details trivially copyable的类型直接memcpy()，
+ *          其他类型逐个移动构造后再析构原对象。
  *
- * \see     UserDefaultAllocator
+ * \note    destination与source指向的区域不能重叠。
+ */
+template <typename DataType>
+inline void relocateObjects(DataType *destination,
+                            DataType *source,
+                            size_t count,
+                            ::NsLib::True_)
+{
+    memcpy((void *)(destination), (const void *)(source),
+           count * sizeof(DataType));
+}
+
+template <typename DataType>
+inline void relocateObjects(DataType *destination,
+                            DataType *source,
+                            size_t count,
+                            ::NsLib::False_)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        ::new((void *)(destination + i)) DataType(std::move(source[i]));
+        source[i].~DataType();
+    }
+}
+
+template <typename DataType>
+inline void relocateObjects(DataType *destination,
+                            DataType *source,
+                            size_t count)
+{
+    ::NsLib::relocateObjects(
+        destination,
+        source,
+        count,
+        typename ::NsLib::TypeTraits<DataType>::IsTriviallyCopyable());
+}
+
+/*!
+ * \brief   ObjectPool和LocalObjectPool的可选功能，可以按位或组合。
+ * \ingroup NsPool
  *
- * \note    不要直接使用ObjectPool类，请使用为ObjectPool提供的宏进行操作。
+ * \details 未开启的功能在编译期被去掉，不会带来运行期开销。\n
+ *          CacheLineStride使块大小和第一个块的地址都按CacheLineSize对齐，
+ *          适用于被不同线程频繁修改的小对象；需要其他对齐值时，
+ *          直接在DataType上使用alignas即可，Pool总是按alignof(DataType)排布。
+ */
+namespace ObjectPoolOption
+{
+
+enum ObjectPoolOptions
+{
+    Default             = 0,
+    OccupancyBitmap     = 1 << 0,   // 维护存活块位图, 支持forEachLive()
+    Statistics          = 1 << 1,   // 维护统计计数, 支持getStatistics()
+    CacheLineStride     = 1 << 2    // 每个块独占整数个cache line, 避免伪共享
+};
+
+enum ObjectPoolLimits
+{
+    CacheLineSize       = 64
+};
+
+}   // ObjectPoolOption
+
+/*!
+ * \brief   创建Object Pool时对内存的预处理方式，可以按位或组合。
+ * \ingroup NsPool
  *
- * \see     NS_DEFINE_OBJECT_POOL_NAME \n
- *          NS_CREATE_OBJECT_POOL      \n
- *          NS_NEW_FROM_OBJECT_POOL    \n
- *          NS_DELETE_IN_OBJECT_POOL   \n
- *          NS_DESTROY_OBJECT_POOL
- * \endinternal
+ * \see     LocalObjectPool::create(unsigned int)
  */
-template <typename  DataType,
-          size_t    capacity = 1000,
-          template  <typename>
-                    class Allocator = ::NsLib::UserDefaultAllocator>
-class ObjectPool
+namespace ObjectPoolPrefault
 {
-    MAKE_CLASS_UNCOPYABLE(ObjectPool);
 
-    typedef Allocator<DataType> PoolAllocator;
-    typedef DataType            DataType_;
+enum ObjectPoolPrefaults
+{
+    None        = 0,
+    Touch       = 1 << 0,   // 逐页写入, 创建时完成所有缺页中断
+    Lock        = 1 << 1,   // mlock()锁定在物理内存中, 不会被换出
+    Parallel    = 1 << 2    // 与Touch一起使用, 大于ParallelThreshold时多线程逐页写入
+};
 
-    // 维护内部的内存链表, 使可读性更好, 思想来自STL的allocator
-    struct FreeBlockNode
-    {
-        FreeBlockNode   *pNext_;
-    };
+enum PrefaultLimits
+{
+    PageSize            = 4096,     // 无法获得系统页大小时使用
+    ParallelThreshold   = 64 * 1024 * 1024
+};
 
+}   // ObjectPoolPrefault
+
+/*!
+ * \internal
+ * \brief   Object Pool创建时的预缺页和内存锁定。
+ * \endinternal
+ */
+class ObjectPoolPrefaulter
+{
 public:
-    ~ObjectPool()
+    static size_t getPageSize()
     {
-        destroy();
+#if defined(__linux__)
+        static const size_t pageSize = (size_t)(sysconf(_SC_PAGESIZE));
+
+        return pageSize;
+#else
+        return ::NsLib::ObjectPoolPrefault::PageSize;
+#endif
     }
 
-    /*!
-     * \internal
-     * \brief   创建Object Pool，分配所需内存。
-     *
-     * \param   无
-     *
-     * \return  无
-     *
-     * \throw   bad_alloc
-     *
-     * \details 使用Object Pool前一定要进行此操作，手动进行Pool的创建，
-     *          这样就可以在运行期不检测Pool是否被创建，最大限度提升运行效率，
-     *          同时给要求精确控制Pool创建时机的用户提供支持。\n
-     *
-     * \note    Debug模式下如果没有调用此函数而直接使用Pool会触发断言。
-     *
-     * \endinternal
-     */
-    static void create() throw (std::bad_alloc)
+    static void touch(char *memPtr, size_t size, bool parallel)
     {
-        assert(!getInstance().isCreated()
-               && "-- you have already create the object pool");
+        size_t threadCount = parallel
+                             && ::NsLib::ObjectPoolPrefault::ParallelThreshold
+                                <= size
+                             ? std::thread::hardware_concurrency()
+                             : 1;
 
-        getInstance().init();
-    }
+        if (threadCount <= 1)
+        {
+            touchPages(memPtr, memPtr + size);
+            return;
+        }
 
-    /*!
-     * \internal
-     * \brief   销毁Object Pool，并释放所有分配的内存。
-     *
-     * \param   无
-     *
-     * \return  无
-     *
-     * \details 对于需要精确控制Pool生命周期的用户，这个函数必不可少。
-     *
-     * \note    Debug模式下如果没有创建Pool而直接调用此函数会触发断言。
-     * \endinternal
-     */
-    static void destroy()
-    {
-        assert(getInstance().isCreated()
-               && "-- you have not create a object pool");
+        // 按页划分, 每个线程负责连续的一段
+        size_t pageSize = getPageSize();
+        size_t pageCount = (size + pageSize - 1) / pageSize;
+        size_t pagesPerThread = (pageCount + threadCount - 1) / threadCount;
+        std::vector<std::thread> threads;
 
-        if (!getInstance().isDestroyed())
+        for (size_t i = 0; i < threadCount; ++i)
         {
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-            NS_TRACE_MEMORY("ObjectPool<",
-                            typeid(DataType).name(),
-                            ">::destroy()",
-                            getInstance().poolMemPtr_);
-#endif
+            size_t first = i * pagesPerThread * pageSize;
+            size_t last = first + pagesPerThread * pageSize;
+
+            if (size <= first)
+            {
+                break;
+            }
 
-            PoolAllocator::deallocate(getInstance().poolMemPtr_);
+            threads.push_back(std::thread(
+                touchPages, memPtr + first, memPtr + (last < size ? last : size)));
+        }
 
-            getInstance().poolMemPtr_ = nullptr;
+        for (size_t i = 0; i < threads.size(); ++i)
+        {
+            threads[i].join();
         }
     }
 
-    static DataType *getObjectMemory()
+    // 失败时(如超出RLIMIT_MEMLOCK)返回false, Pool仍然可以正常使用
+    static bool lock(char *memPtr, size_t size)
     {
-        assert(getInstance().isCreated()
-               && "-- you have not create a object pool");
-        assert(0 < getInstance().currentCapacity_
-               && "-- the object pool has not enough object");
+#if defined(__linux__)
+        return 0 == mlock(memPtr, size);
+#else
+        (void)(memPtr);
+        (void)(size);
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        DataType *ptr = getInstance().getMemoryBlock();
+        return false;
+#endif
+    }
 
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::getObject()",
-                        ptr);
-        return ptr;
+    static void unlock(char *memPtr, size_t size)
+    {
+#if defined(__linux__)
+        munlock(memPtr, size);
 #else
-        return getInstance().getMemoryBlock();
+        (void)(memPtr);
+        (void)(size);
 #endif
     }
 
-    static void deleteObject(DataType *objectPtr)
+private:
+    static void touchPages(char *first, char *last)
     {
-        assert(getInstance().isPointerValid(objectPtr)
-               && "-- you have not create a object pool");
+        size_t pageSize = getPageSize();
+        volatile char *page = first;
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::deleteObject()",
-                        objectPtr);
-#endif
+        for (; page < last; page += pageSize)
+        {
+            *page = 0;
+        }
 
-        objectPtr->~DataType();
+        // 最后一页可能没有被上面的步长覆盖
+        if (first < last)
+        {
+            *(volatile char *)(last - 1) = 0;
+        }
+    }
+};
+
+/*!
+ * \internal
+ * \brief   Object Pool快照文件的文件头，各字段均与地址无关。
+ * \endinternal
+ */
+struct ObjectPoolSnapshotHeader
+{
+    uint32_t    magic_;
+    uint32_t    version_;
+    uint64_t    dataSize_;              // 块大小
+    uint64_t    capacity_;
+    uint64_t    currentCapacity_;
+    uint64_t    firstFreeIndex_;        // firstFreeBlock_的块索引
+    uint64_t    slabSize_;              // 块区域的字节数
+    uint64_t    occupancyWordCount_;    // 存活块位图的字数, 未开启时为0
+    uint64_t    pageSize_;              // 写入时的页大小, 即文件头所占的字节数
+};
+
+/*!
+ * \internal
+ * \brief   Object Pool快照文件的读写。
+ *
+ * \details 文件布局为：文件头(占一页)、块区域、存活块位图。\n
+ *          块区域从页边界开始，恢复时可以直接mmap()作为Pool的内存。\n
+ *          页大小取自sysconf(_SC_PAGESIZE)并记录在文件头中，
+ *          页大小不同的机器之间不能使用同一个快照。
+ * \endinternal
+ */
+class ObjectPoolSnapshotFile
+{
+public:
+    static const uint32_t magic_ = 0x504F534E;     // "NSOP"
+    static const uint32_t version_ = 2;
 
-        getInstance().returnMemoryBlock((FreeBlockNode *)(objectPtr));
+    static size_t getPageSize()
+    {
+        return ::NsLib::ObjectPoolPrefaulter::getPageSize();
     }
 
-    static void deallocateMemory(DataType *objectPtr)
+    static bool write(const char *fileName,
+                      const ::NsLib::ObjectPoolSnapshotHeader &header,
+                      const void *slab,
+                      const uint64_t *occupancyWords)
     {
-        assert(getInstance().isPointerValid(objectPtr)
-               && "-- you have not create a object pool");
+#if defined(__linux__)
+        int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::deallocateMemory()",
-                        objectPtr);
-#endif
+        if (-1 == fd)
+        {
+            return false;
+        }
+
+        // 文件头之后到页边界的部分由lseek()留空, 读出时为0
+        bool succeeded =
+            writeAll(fd, &header, sizeof(header))
+            && (off_t)(header.pageSize_)
+               == lseek(fd, (off_t)(header.pageSize_), SEEK_SET)
+            && writeAll(fd, slab, header.slabSize_)
+            && writeAll(fd,
+                        occupancyWords,
+                        header.occupancyWordCount_ * sizeof(uint64_t));
+
+        return 0 == close(fd) && succeeded;
+#else
+        (void)(fileName);
+        (void)(header);
+        (void)(slab);
+        (void)(occupancyWords);
 
-        getInstance().returnMemoryBlock((FreeBlockNode *)(objectPtr));
+        return false;
+#endif
     }
 
+    // header中的布局字段由调用者填好, 与文件一致时才映射, 失败返回nullptr
+    static void *map(const char *fileName,
+                     ::NsLib::ObjectPoolSnapshotHeader &header,
+                     uint64_t *occupancyWords)
+    {
+#if defined(__linux__)
+        int fd = open(fileName, O_RDONLY);
 
-// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
-#ifndef  _NS_OBJECT_POOL_DEBUG_
-private:
+        if (-1 == fd)
+        {
+            return nullptr;
+        }
+
+        ::NsLib::ObjectPoolSnapshotHeader fileHeader;
+        size_t occupancySize = header.occupancyWordCount_ * sizeof(uint64_t);
+        off_t occupancyOffset = header.pageSize_ + header.slabSize_;
+        struct stat fileStat;
+        void *slab = MAP_FAILED;
+
+        if (sizeof(fileHeader) == pread(fd, &fileHeader, sizeof(fileHeader), 0)
+            && isCompatible(header, fileHeader)
+            && 0 == fstat(fd, &fileStat)
+            && occupancyOffset + (off_t)(occupancySize) <= fileStat.st_size
+            && (ssize_t)(occupancySize) == pread(fd,
+                                                 occupancyWords,
+                                                 occupancySize,
+                                                 occupancyOffset))
+        {
+            // MAP_PRIVATE: 之后的修改不会写回快照文件
+            slab = mmap(nullptr,
+                        header.slabSize_,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE,
+                        fd,
+                        header.pageSize_);
+        }
+
+        close(fd);
+
+        if (MAP_FAILED == slab)
+        {
+            return nullptr;
+        }
+
+        header = fileHeader;
+
+        return slab;
 #else
-public:
+        (void)(fileName);
+        (void)(header);
+        (void)(occupancyWords);
+
+        return nullptr;
 #endif
+    }
 
-    ObjectPool() :
-        capacity_{capacity},
-        currentCapacity_{capacity},
-        poolMemPtr_{nullptr},
-        alignedMemPtr_{nullptr}
+    static void unmap(void *slab, size_t slabSize)
     {
-            if (sizeof(DataType) <= sizeof(FreeBlockNode *))
-            {
-                dataSize_ = sizeof(FreeBlockNode *);
-            }
-            else
-            {
-                dataSize_ = sizeof(DataType);
-            }
+#if defined(__linux__)
+        munmap(slab, slabSize);
+#else
+        (void)(slab);
+        (void)(slabSize);
+#endif
     }
 
-    static ObjectPool<DataType, capacity, Allocator> &getInstance()
+private:
+    static bool isCompatible(const ::NsLib::ObjectPoolSnapshotHeader &expected,
+                             const ::NsLib::ObjectPoolSnapshotHeader &actual)
     {
-        static ObjectPool<DataType, capacity, Allocator> poolInstance;
-
-        return poolInstance;
+        return magic_ == actual.magic_
+               && version_ == actual.version_
+               && expected.dataSize_ == actual.dataSize_
+               && expected.capacity_ == actual.capacity_
+               && expected.slabSize_ == actual.slabSize_
+               && expected.occupancyWordCount_ == actual.occupancyWordCount_
+               && expected.pageSize_ == actual.pageSize_
+               && actual.currentCapacity_ <= actual.capacity_
+               && actual.firstFreeIndex_ <= actual.capacity_;
     }
 
-    // 为了内存访问效率, 内存分配要满足数据类型内存对齐的需要,
-    // 这里经过一些trick来实现可移植的分配手段
-    void init()
+#if defined(__linux__)
+    static bool writeAll(int fd, const void *data, size_t size)
     {
-#ifdef _NS_DEBUG_
-        NS_DEBUG_MESSAGE_4("ObjectPool<",
-                           typeid(DataType).name(),
-                           ">::init() sizeof(DataType): ",
-                           sizeof(DataType));
-        NS_DEBUG_MESSAGE_4("ObjectPool<",
-                           typeid(DataType).name(),
-                           ">::init() dataSize_: ",
-                           dataSize_);
-        NS_DEBUG_MESSAGE_4("ObjectPool<",
-                           typeid(DataType).name(),
-                           ">::init() alignof(DataType): ",
-                           alignof(DataType));
-#endif
+        const char *memPtr = (const char *)(data);
 
-        // 多分配一个dataSize_大小, 因为后面的算法需要在分配了capacity_个对象后,
-        // 有一个dataSize_大小保存firstFreeBlock_指针
-        size_t size = dataSize_ * (capacity_ + 1) + alignof(DataType);
+        while (0 < size)
+        {
+            ssize_t written = ::write(fd, memPtr, size);
 
-#ifdef _NS_DEBUG_
-        NS_DEBUG_MESSAGE_4("ObjectPool<",
-                           typeid(DataType).name(),
-                           ">::init() size: ",
-                           size);
-#endif
+            if (written <= 0)
+            {
+                return false;
+            }
 
-        poolMemPtr_ = PoolAllocator::allocate(size);
+            memPtr += written;
+            size -= (size_t)(written);
+        }
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::init() poolMemPtr",
-                        poolMemPtr_);
+        return true;
+    }
 #endif
+};
 
-        alignedMemPtr_ = (DataType *)(
-            ((uintptr_t)(poolMemPtr_) + alignof(DataType) - 1)
-            & (uintptr_t)(~(alignof(DataType) - 1)));
-
+/*!
+ * \internal
+ * \brief   存活块位图，每个块占一位，未开启时为空实现。
+ * \endinternal
+ */
+template <bool enabled>
+class ObjectPoolOccupancy
+{
+public:
+    void init(size_t)
+    {
+    }
+
+    void release()
+    {
+    }
+
+    void set(size_t)
+    {
+    }
+
+    void clear(size_t)
+    {
+    }
+
+    void clearAll()
+    {
+    }
+
+    bool test(size_t) const
+    {
+        return true;
+    }
+
+    uint64_t *getWords()
+    {
+        return nullptr;
+    }
+
+    size_t getWordCount() const
+    {
+        return 0;
+    }
+
+    template <typename Function>
+    void forEach(Function) const
+    {
+    }
+};
+
+template <>
+class ObjectPoolOccupancy<true>
+{
+public:
+    void init(size_t capacity)
+    {
+        words_.assign((capacity + 63) / 64, 0);
+    }
+
+    void release()
+    {
+        std::vector<uint64_t>().swap(words_);
+    }
+
+    void set(size_t index)
+    {
+        words_[index / 64] |= (uint64_t)(1) << (index % 64);
+    }
+
+    void clear(size_t index)
+    {
+        words_[index / 64] &= ~((uint64_t)(1) << (index % 64));
+    }
+
+    void clearAll()
+    {
+        words_.assign(words_.size(), 0);
+    }
+
+    bool test(size_t index) const
+    {
+        return 0 != (words_[index / 64] & ((uint64_t)(1) << (index % 64)));
+    }
+
+    uint64_t *getWords()
+    {
+        return words_.data();
+    }
+
+    size_t getWordCount() const
+    {
+        return words_.size();
+    }
+
+    // 按地址顺序访问每个存活块的索引, 全空的字直接跳过
+    template <typename Function>
+    void forEach(Function function) const
+    {
+        for (size_t i = 0; i < words_.size(); ++i)
+        {
+            uint64_t word = words_[i];
+
+            while (0 != word)
+            {
+                function(i * 64 + findFirstSet(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    static size_t findFirstSet(uint64_t word)
+    {
+#if defined(__GNUC__)
+        return (size_t)(__builtin_ctzll(word));
+#else
+        size_t index = 0;
+
+        while (0 == (word & 1))
+        {
+            word >>= 1;
+            ++index;
+        }
+
+        return index;
+#endif
+    }
+
+    std::vector<uint64_t>   words_;
+};
+
+/*!
+ * \struct  ObjectPoolStatistics NsPool.h
+ * \brief   Object Pool的统计数据。
+ * \ingroup NsPool
+ *
+ * \note    liveCount_和usedBytes_不是原子计数，
+ *          跨线程读取时需要由用户保证与分配、释放互斥。
+ *
+ * \see     LocalObjectPool::getStatistics()
+ */
+struct ObjectPoolStatistics
+{
+    size_t      liveCount_;         // 当前存活对象数
+    size_t      highWaterMark_;     // 存活对象数的历史最大值
+    uint64_t    allocationCount_;   // 累计分配次数
+    uint64_t    freeCount_;         // 累计释放次数
+    uint64_t    failureCount_;      // 容量耗尽导致的分配失败次数
+    size_t      reservedBytes_;     // 向Allocator申请的字节数
+    size_t      usedBytes_;         // 存活对象占用的字节数
+};
+
+/*!
+ * \internal
+ * \brief   Object Pool的统计计数，未开启时为空实现。
+ *
+ * \details 累计计数分散在多个按cache line对齐的分片中，
+ *          每个线程固定使用一个分片，多线程使用同一个Pool时不会争抢同一个cache line。
+ * \endinternal
+ */
+template <bool enabled>
+class ObjectPoolCounters
+{
+public:
+    void init(size_t)
+    {
+    }
+
+    void onAllocate(size_t, size_t)
+    {
+    }
+
+    void onFree(size_t)
+    {
+    }
+
+    void onFailure()
+    {
+    }
+};
+
+template <>
+class ObjectPoolCounters<true>
+{
+    static const size_t shardCount_ = 16;
+
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t>   allocationCount_;
+        std::atomic<uint64_t>   freeCount_;
+        std::atomic<uint64_t>   failureCount_;
+    };
+
+public:
+    void init(size_t reservedBytes)
+    {
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            shards_[i].allocationCount_.store(0, std::memory_order_relaxed);
+            shards_[i].freeCount_.store(0, std::memory_order_relaxed);
+            shards_[i].failureCount_.store(0, std::memory_order_relaxed);
+        }
+
+        highWaterMark_.store(0, std::memory_order_relaxed);
+        reservedBytes_ = reservedBytes;
+    }
+
+    void onAllocate(size_t count, size_t liveCount)
+    {
+        getShard().allocationCount_.fetch_add(count, std::memory_order_relaxed);
+
+        // 历史最大值很少变化, 绝大多数情况下只有一次读
+        size_t highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+
+        while (highWaterMark < liveCount
+               && !highWaterMark_.compare_exchange_weak(
+                      highWaterMark, liveCount, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void onFree(size_t count)
+    {
+        getShard().freeCount_.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void onFailure()
+    {
+        getShard().failureCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void collect(::NsLib::ObjectPoolStatistics &statistics) const
+    {
+        statistics.allocationCount_ = 0;
+        statistics.freeCount_ = 0;
+        statistics.failureCount_ = 0;
+
+        for (size_t i = 0; i < shardCount_; ++i)
+        {
+            statistics.allocationCount_ +=
+                shards_[i].allocationCount_.load(std::memory_order_relaxed);
+            statistics.freeCount_ +=
+                shards_[i].freeCount_.load(std::memory_order_relaxed);
+            statistics.failureCount_ +=
+                shards_[i].failureCount_.load(std::memory_order_relaxed);
+        }
+
+        statistics.highWaterMark_ =
+            highWaterMark_.load(std::memory_order_relaxed);
+        statistics.reservedBytes_ = reservedBytes_;
+    }
+
+private:
+    Shard &getShard()
+    {
+        return shards_[getShardIndex()];
+    }
+
+    // 每个线程第一次使用时按顺序分配一个分片
+    static size_t getShardIndex()
+    {
+        static std::atomic<size_t> nextShard{0};
+        static thread_local size_t shardIndex =
+            nextShard.fetch_add(1, std::memory_order_relaxed) % shardCount_;
+
+        return shardIndex;
+    }
+
+    Shard                   shards_[shardCount_];
+    std::atomic<size_t>     highWaterMark_;
+    size_t                  reservedBytes_;
+};
+
+/*!
+ * \class   LocalObjectPool NsPool.h
+ * \brief   可以作为成员或局部变量持有的Object Pool实例。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
+ * \tparam  [可选]unsigned int options - ObjectPoolOption的组合[默认 = Default]
+ *
+ * \details 与ObjectPool的内存布局和接口完全相同，区别在于ObjectPool对每一组
+ *          <DataType, capacity, Allocator>只有一个全局实例，而LocalObjectPool
+ *          可以创建任意多个相互独立的实例。\n
+ *          例如每局比赛、每个工作线程各自持有一个LocalObjectPool，
+ *          它们的空闲链表和生命周期互不影响，比赛结束时调用destroy()
+ *          或者直接析构LocalObjectPool，即可一次释放该局的所有对象。
+ *
+ * \note    destroy()和析构函数只释放内存，不会调用存活对象的析构函数。\n
+ *          不是线程安全的，一个实例只应由一个线程使用，或者由用户自行加锁。
+ *
+ * \code
+ * // 示例：
+ * class Match
+ * {
+ * public:
+ *      Match()
+ *      {
+ *          bulletPool_.create();
+ *      }
+ *
+ *      void fire(int x, int y)
+ *      {
+ *          Bullet *bullet = NS_NEW_FROM_LOCAL_OBJECT_POOL(bulletPool_, x, y);
+ *          // ...
+ *          NS_DELETE_IN_LOCAL_OBJECT_POOL(bulletPool_, bullet);
+ *      }
+ *
+ * private:
+ *      // 随Match一起析构，所有子弹占用的内存一次释放。
+ *      ::NsLib::LocalObjectPool<Bullet, 10000>   bulletPool_;
+ * };
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <typename      DataType,
+          size_t        capacity = 1000,
+          template      <typename>
+                        class Allocator = ::NsLib::UserDefaultAllocator,
+          unsigned int  options = ::NsLib::ObjectPoolOption::Default>
+class LocalObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(LocalObjectPool);
+
+    // 线程缓存需要批量访问共享Pool的内部链表
+    template <typename, size_t, template <typename> class, size_t, typename>
+    friend class ::NsLib::ThreadCachedObjectPool;
+
+    // 需要将Pool的内存绑定到指定的NUMA结点
+    template <typename, size_t, template <typename> class, size_t, typename>
+    friend class ::NsLib::NumaObjectPool;
+
+    typedef Allocator<DataType> PoolAllocator;
+
+    // 维护内部的内存链表, 使可读性更好, 思想来自STL的allocator
+    struct FreeBlockNode
+    {
+        FreeBlockNode   *pNext_;
+    };
+
+    static const bool hasOccupancyBitmap_ =
+        0 != (options & ::NsLib::ObjectPoolOption::OccupancyBitmap);
+
+    typedef ::NsLib::ObjectPoolOccupancy<hasOccupancyBitmap_> Occupancy;
+
+    static const bool hasStatistics_ =
+        0 != (options & ::NsLib::ObjectPoolOption::Statistics);
+
+    typedef ::NsLib::ObjectPoolCounters<hasStatistics_> Counters;
+
+    // 块的对齐要求, 开启CacheLineStride时至少为一个cache line,
+    // 块大小同样向上取整到它的整数倍
+    static const size_t slotAlignment_ =
+        0 != (options & ::NsLib::ObjectPoolOption::CacheLineStride)
+        && alignof(DataType) < ::NsLib::ObjectPoolOption::CacheLineSize
+        ? (size_t)(::NsLib::ObjectPoolOption::CacheLineSize)
+        : alignof(DataType);
+
+    // 析构函数为trivial时, 删除和整体销毁都不需要访问对象
+    typedef typename ::NsLib::TypeTraits<DataType>::HasTrivialDestructor
+            HasTrivialDestructor_;
+
+public:
+    // NS_NEW_FROM_OBJECT_POOL等宏需要访问
+    typedef DataType            DataType_;
+
+    LocalObjectPool() :
+        capacity_{capacity},
+        currentCapacity_{capacity},
+        poolMemPtr_{nullptr},
+        alignedMemPtr_{nullptr},
+        firstFreeBlock_{nullptr},
+        memoryLocked_{false},
+        mappedSize_{0}
+    {
+            if (sizeof(DataType) <= sizeof(FreeBlockNode *))
+            {
+                dataSize_ = sizeof(FreeBlockNode *);
+            }
+            else
+            {
+                dataSize_ = sizeof(DataType);
+            }
+
+            dataSize_ = (dataSize_ + slotAlignment_ - 1)
+                        & ~(slotAlignment_ - 1);
+    }
+
+    ~LocalObjectPool()
+    {
+        if (!isDestroyed())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建Object Pool，分配所需内存。
+     *
+     * \param   无
+     *
+     * \return  无
+     *
+     * \throw   bad_alloc
+     *
+     * \details 使用Object Pool前一定要进行此操作，手动进行Pool的创建，
+     *          这样就可以在运行期不检测Pool是否被创建，最大限度提升运行效率，
+     *          同时给要求精确控制Pool创建时机的用户提供支持。\n
+     *
+     * \note    Debug模式下如果没有调用此函数而直接使用Pool会触发断言。\n
+     *          销毁之后可以再次创建。
+     */
+    void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!isCreated()
+               && "-- you have already create the object pool");
+
+        init(::NsLib::ObjectPoolPrefault::None);
+    }
+
+    /*!
+     * \brief   创建Object Pool，并按prefaultMode预处理内存。
+     *
+     * \param   prefaultMode - ObjectPoolPrefault的组合
+     *
+     * \return  无
+     *
+     * \throw   bad_alloc
+     *
+     * \details Touch在创建时逐页写入整个Pool，之后第一次使用每个块时
+     *          不会再在帧内触发缺页中断；\n
+     *          Lock使用mlock()锁定Pool的内存，失败时(如超出RLIMIT_MEMLOCK)
+     *          Pool仍然可以正常使用，可通过isMemoryLocked()查询结果；\n
+     *          Parallel在Pool大于64MB时使用所有硬件线程并行逐页写入。
+     *
+     * \note    非Linux平台不支持Lock。
+     */
+    void create(unsigned int prefaultMode) NS_THROW(std::bad_alloc)
+    {
+        assert(!isCreated()
+               && "-- you have already create the object pool");
+
+        init(prefaultMode);
+    }
+
+    /*!
+     * \brief   销毁Object Pool，并释放所有分配的内存。
+     *
+     * \param   无
+     *
+     * \return  无
+     *
+     * \details 对于需要精确控制Pool生命周期的用户，这个函数必不可少。
+     *
+     * \note    Debug模式下如果没有创建Pool而直接调用此函数会触发断言。
+     */
+    void destroy()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        if (!isDestroyed())
+        {
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+            NS_TRACE_MEMORY("ObjectPool<",
+                            typeid(DataType).name(),
+                            ">::destroy()",
+                            poolMemPtr_);
+#endif
+
+            if (memoryLocked_)
+            {
+                ::NsLib::ObjectPoolPrefaulter::unlock((char *)(poolMemPtr_),
+                                                      getPoolMemorySize());
+                memoryLocked_ = false;
+            }
+
+            if (0 != mappedSize_)
+            {
+                ::NsLib::ObjectPoolSnapshotFile::unmap(poolMemPtr_, mappedSize_);
+                mappedSize_ = 0;
+            }
+            else
+            {
+                PoolAllocator::deallocate(poolMemPtr_);
+            }
+
+            poolMemPtr_ = nullptr;
+            alignedMemPtr_ = nullptr;
+            occupancy_.release();
+        }
+    }
+
+    DataType *getObjectMemory()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        if (hasStatistics_ && 0 == currentCapacity_)
+        {
+            counters_.onFailure();
+        }
+
+        assert(0 < currentCapacity_
+               && "-- the object pool has not enough object");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        DataType *ptr = getMemoryBlock();
+
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getObject()",
+                        ptr);
+        return ptr;
+#else
+        return getMemoryBlock();
+#endif
+    }
+
+    void deleteObject(DataType *objectPtr)
+    {
+        assert(isPointerValid(objectPtr)
+               && "-- you have not create a object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deleteObject()",
+                        objectPtr);
+#endif
+
+        destroyObject(objectPtr, HasTrivialDestructor_());
+
+        returnMemoryBlock((FreeBlockNode *)(objectPtr));
+    }
+
+    void deallocateMemory(DataType *objectPtr)
+    {
+        assert(isPointerValid(objectPtr)
+               && "-- you have not create a object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        returnMemoryBlock((FreeBlockNode *)(objectPtr));
+    }
+
+    /*!
+     * \brief   分配对象并用args构造，参数完美转发给构造函数。
+     *
+     * \param   [可选]args - 构造对象所需参数
+     *
+     * \return  构造好的对象指针
+     *
+     * \details 构造函数抛出异常时，块会先归还给Pool，再继续抛出异常。
+     */
+    template <typename... Args>
+    DataType *construct(Args&&... args)
+    {
+        DataType *objectPtr = getObjectMemory();
+
+        try
+        {
+            return ::new((void *)(objectPtr))
+                DataType(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            returnMemoryBlock((FreeBlockNode *)(objectPtr));
+            throw;
+        }
+    }
+
+    /*!
+     * \brief   一次分配count个对象的内存，不进行构造。
+     *
+     * \param   count - 要分配的个数
+     * \param   objectPtrs - 输出，至少能容纳count个指针
+     *
+     * \return  无
+     *
+     * \details 先从空闲链表中连续摘下回收过的块，剩余部分直接在从未分配过的区域中
+     *          一次划出，不需要逐个推进。
+     *
+     * \note    Debug模式下若剩余容量不足count会触发断言。
+     */
+    void getObjectMemoryBatch(size_t count, DataType **objectPtrs)
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        if (hasStatistics_ && currentCapacity_ < count)
+        {
+            counters_.onFailure();
+        }
+
+        assert(count <= currentCapacity_
+               && "-- the object pool has not enough object");
+
+        getMemoryBlocks(count, objectPtrs);
+    }
+
+    /*!
+     * \brief   一次删除count个对象，会自动调用析构函数。
+     *
+     * \param   objectPtrs - 待删除的对象指针
+     * \param   count - 待删除的个数
+     *
+     * \return  无
+     *
+     * \details 所有块先在内部串成一段链表，再一次接到空闲链表头部。\n
+     *          析构函数为trivial的类型不会逐个遍历对象。
+     */
+    void deleteObjectBatch(DataType **objectPtrs, size_t count)
+    {
+#ifndef NDEBUG
+        for (size_t i = 0; i < count; ++i)
+        {
+            assert(isPointerValid(objectPtrs[i])
+                   && "-- the object is not allocated from this object pool");
+        }
+#endif
+
+        destroyObjects(objectPtrs, count, HasTrivialDestructor_());
+
+        returnMemoryBlocks(objectPtrs, count);
+    }
+
+    void deallocateMemoryBatch(DataType **objectPtrs, size_t count)
+    {
+#ifndef NDEBUG
+        for (size_t i = 0; i < count; ++i)
+        {
+            assert(isPointerValid(objectPtrs[i])
+                   && "-- the object is not allocated from this object pool");
+        }
+#endif
+
+        returnMemoryBlocks(objectPtrs, count);
+    }
+
+    /*!
+     * \brief   分配一段至少size字节的连续内存，由若干个相邻的块组成，不进行构造。
+     *
+     * \param   size - 需要的字节数
+     *
+     * \return  连续内存的首地址，无法满足时返回nullptr
+     *
+     * \details 只有空闲链表中没有回收过的块时，未分配区域才是一整段已知的连续内存，
+     *          此时直接推进未分配区域的起点，时间复杂度O(1)；
+     *          否则不遍历空闲链表查找相邻的块，直接返回nullptr，由调用者改用其他分配方式。\n
+     *          供INewFromObjectPool的operator new[]使用。
+     *
+     * \note    其中的块对Pool来说和普通的存活对象一样，
+     *          但并不是从块的起始位置开始存放对象(数组前面可能有编译器保存的元素个数)，
+     *          所以含有这种内存的Pool不能调用compact()、resetAndDestroyObjects()
+     *          和forEachLive()。
+     */
+    void *getContiguousMemory(size_t size)
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        size_t count = (size + dataSize_ - 1) / dataSize_;
+
+        if (0 == count
+            || currentCapacity_ < count
+            || nullptr != firstFreeBlock_->pNext_)
+        {
+            return nullptr;
+        }
+
+        FreeBlockNode *run = firstFreeBlock_;
+
+        currentCapacity_ -= count;
+
+        firstFreeBlock_ = (FreeBlockNode *)((char *)(run) + dataSize_ * count);
+        firstFreeBlock_->pNext_ = nullptr;
+
+        if (hasOccupancyBitmap_)
+        {
+            size_t first = getBlockIndex(run);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                occupancy_.set(first + i);
+            }
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onAllocate(count, capacity_ - currentCapacity_);
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getContiguousMemory() run",
+                        run);
+#endif
+
+        return run;
+    }
+
+    /*!
+     * \brief   归还getContiguousMemory()分配的内存，不调用析构函数。
+     *
+     * \param   memPtr - getContiguousMemory()的返回值
+     * \param   size - 与分配时相同的字节数
+     *
+     * \return  无
+     *
+     * \details 其中的块按地址顺序串成一段链表，一次接到空闲链表头部。
+     */
+    void deallocateContiguousMemory(void *memPtr, size_t size)
+    {
+        assert(isPointerValid(static_cast<DataType *>(memPtr))
+               && "-- the memory is not allocated from this object pool");
+
+        size_t count = (size + dataSize_ - 1) / dataSize_;
+        char *block = static_cast<char *>(memPtr);
+
+        if (hasOccupancyBitmap_)
+        {
+            size_t first = getBlockIndex((FreeBlockNode *)(block));
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                assert(occupancy_.test(first + i)
+                       && "-- the memory has already been deallocated");
+
+                occupancy_.clear(first + i);
+            }
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onFree(count);
+        }
+
+        for (size_t i = 0; i + 1 < count; ++i, block += dataSize_)
+        {
+            ((FreeBlockNode *)(block))->pNext_ =
+                (FreeBlockNode *)(block + dataSize_);
+        }
+
+        ((FreeBlockNode *)(block))->pNext_ = firstFreeBlock_;
+        firstFreeBlock_ = (FreeBlockNode *)(memPtr);
+
+        currentCapacity_ += count;
+    }
+
+    /*!
+     * \brief   一次丢弃Pool中所有已分配的对象，不调用析构函数。
+     *
+     * \param   无
+     *
+     * \return  无
+     *
+     * \details 只将空闲链表重置为初始状态，时间复杂度O(1)，
+     *          适用于每帧或每局结束时整体丢弃的对象。\n
+     *          之前分配的所有指针都将失效。
+     *
+     * \note    对象持有的资源不会被释放，需要析构的类型请使用resetAndDestroyObjects()。
+     */
+    void reset()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        firstFreeBlock_ = (FreeBlockNode *)(alignedMemPtr_);
+        firstFreeBlock_->pNext_ = nullptr;
+        occupancy_.clearAll();
+
+        currentCapacity_ = capacity_;
+    }
+
+    /*!
+     * \brief   先调用所有存活对象的析构函数，再重置Pool。
+     *
+     * \param   无
+     *
+     * \return  无
+     *
+     * \details 对于析构函数为trivial的类型，等同于reset()；\n
+     *          否则需要遍历一次空闲链表来确定哪些块是存活的对象，
+     *          时间复杂度为O(capacity)，但不需要逐个调用NS_DELETE_IN_OBJECT_POOL。
+     */
+    void resetAndDestroyObjects()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        destroyLiveObjects(HasTrivialDestructor_());
+
+        reset();
+    }
+
+    /*!
+     * \brief   将所有存活对象搬移到Pool的最前面，使它们连续存放。
+     *
+     * \param   callback - 每搬移一个对象调用一次callback(oldPtr, newPtr)
+     *
+     * \return  搬移的对象个数
+     *
+     * \details 两个指针分别从前向后寻找空闲块、从后向前寻找存活对象，
+     *          每个对象最多搬移一次，之后空闲链表被重建为单一的未分配区域，
+     *          此后的分配按地址顺序进行。\n
+     *          trivially copyable的类型使用memcpy()搬移，
+     *          其他类型先移动构造再析构原对象。\n
+     *          时间复杂度为O(已使用过的块数)。
+     *
+     * \note    callback被调用时oldPtr处的对象已经不存在，只能用作查找的键，
+     *          用户需要在callback中更新所有指向该对象的指针。\n
+     *          与trim()一起使用，可以在负载高峰之后释放Pool尾部的物理内存。\n
+     *          不是线程安全的。
+     */
+    template <typename RelocationCallback>
+    size_t compact(RelocationCallback callback)
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        std::vector<bool> isFree;
+        size_t liveCount = capacity_ - currentCapacity_;
+        size_t freeIndex = 0;
+        size_t liveIndex = markFreeBlocks(isFree);
+        size_t moveCount = 0;
+
+        for (;;)
+        {
+            while (freeIndex < liveCount && !isFree[freeIndex])
+            {
+                ++freeIndex;
+            }
+
+            if (liveCount <= freeIndex)
+            {
+                break;
+            }
+
+            // [0, liveCount)中的空闲块数等于[liveCount, liveIndex)中的存活对象数
+            do
+            {
+                --liveIndex;
+            } while (isFree[liveIndex]);
+
+            DataType *oldPtr = (DataType *)(getBlock(liveIndex));
+            DataType *newPtr = (DataType *)(getBlock(freeIndex));
+
+            ::NsLib::relocateObjects(newPtr, oldPtr, 1);
+
+            if (hasOccupancyBitmap_)
+            {
+                occupancy_.clear(liveIndex);
+                occupancy_.set(freeIndex);
+            }
+
+            callback(oldPtr, newPtr);
+
+            ++freeIndex;
+            ++moveCount;
+        }
+
+        firstFreeBlock_ = getBlock(liveCount);
+        firstFreeBlock_->pNext_ = nullptr;
+
+        return moveCount;
+    }
+
+    size_t compact()
+    {
+        return compact([](DataType *, DataType *) {});
+    }
+
+    /*!
+     * \brief   将Pool尾部不再使用的物理内存还给操作系统，地址空间保持不变。
+     *
+     * \param   无
+     *
+     * \return  释放的字节数
+     *
+     * \details 找到最后一个存活对象，之后的空闲块从空闲链表中摘下，
+     *          并入从未分配过的区域；该区域中完整的页通过madvise(MADV_DONTNEED)释放，
+     *          RSS随之下降，再次分配到这些块时由缺页中断重新提供零页。\n
+     *          时间复杂度为O(已使用过的块数)，适合在空闲的tick中调用。
+     *
+     * \note    空闲块中保存着空闲链表的指针，所以存活对象之间的空闲页不会被释放，
+     *          先调用compact()可以把存活对象集中到Pool的前面。\n
+     *          mlock()锁定的Pool以及非Linux平台只调整空闲链表，返回0。\n
+     *          不是线程安全的。
+     */
+    size_t trim()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        std::vector<bool> isFree;
+        size_t unusedIndex = markFreeBlocks(isFree);
+        size_t frontier = unusedIndex;
+
+        while (0 < frontier && isFree[frontier - 1])
+        {
+            --frontier;
+        }
+
+        if (frontier < unusedIndex)
+        {
+            // 只保留frontier之前的空闲块, 链表中的相对顺序不变
+            FreeBlockNode **link = &firstFreeBlock_;
+            FreeBlockNode *block = firstFreeBlock_;
+
+            while (nullptr != block->pNext_)
+            {
+                if (getBlockIndex(block) < frontier)
+                {
+                    *link = block;
+                    link = &block->pNext_;
+                }
+
+                block = block->pNext_;
+            }
+
+            *link = getBlock(frontier);
+            (*link)->pNext_ = nullptr;
+        }
+
+        // 未分配区域的第一个块保存着链表结束标志, 不能释放
+        return releasePages((char *)(getBlock(frontier)) + sizeof(FreeBlockNode),
+                            (char *)(getBlock(capacity_ + 1)));
+    }
+
+    /*!
+     * \brief   按地址顺序对每个存活对象调用function(DataType &)。
+     *
+     * \param   function - 函数对象或lambda
+     *
+     * \return  无
+     *
+     * \details 遍历存活块位图，全空的64个块一次跳过，其余用find-first-set定位，
+     *          访问顺序与内存顺序一致，便于硬件预取。
+     *
+     * \note    只有开启ObjectPoolOption::OccupancyBitmap时才能使用。\n
+     *          遍历过程中不要分配或删除对象。
+     */
+    template <typename Function>
+    void forEachLive(Function function)
+    {
+        static_assert(hasOccupancyBitmap_,
+                      "-- forEachLive() requires ObjectPoolOption::OccupancyBitmap");
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        forEachLiveObject(function);
+    }
+
+    /*!
+     * \brief   获得Pool的统计数据。
+     *
+     * \param   无
+     *
+     * \return  ObjectPoolStatistics
+     *
+     * \details 存活对象数由capacity_ - currentCapacity_得到，
+     *          累计计数在create()时清零，reset()不会清零。
+     *
+     * \note    只有开启ObjectPoolOption::Statistics时才能使用。\n
+     *          只有分片的累计计数(allocationCount_, freeCount_, failureCount_,
+     *          highWaterMark_)可以在其他线程中读取；
+     *          liveCount_和usedBytes_来自非原子的currentCapacity_，
+     *          需要在使用Pool的线程中或者持有用户自己的锁时调用。
+     */
+    ::NsLib::ObjectPoolStatistics getStatistics() const
+    {
+        static_assert(hasStatistics_,
+                      "-- getStatistics() requires ObjectPoolOption::Statistics");
+
+        ::NsLib::ObjectPoolStatistics statistics;
+
+        counters_.collect(statistics);
+
+        statistics.liveCount_ = capacity_ - currentCapacity_;
+        statistics.usedBytes_ = statistics.liveCount_ * sizeof(DataType);
+
+        return statistics;
+    }
+
+    /*!
+     * \brief   将Pool的全部状态保存到快照文件，用于快速重启。
+     *
+     * \param   fileName - 快照文件名，已存在时会被覆盖
+     *
+     * \return  写入失败或平台不支持时返回false
+     *
+     * \details 写入块区域、空闲链表状态和存活块位图；
+     *          空闲链表中的指针在写入期间临时改为块索引，写完后恢复，
+     *          因此文件与Pool所在的地址无关。
+     *
+     * \note    只支持trivially copyable的类型。\n
+     *          对象中保存的指向其他Pool对象的指针在恢复后不再有效，
+     *          请使用块索引或SlotMap的句柄。\n
+     *          保存期间不要在其他线程中使用Pool。
+     *
+     * \see     restoreSnapshot()
+     */
+    bool saveSnapshot(const char *fileName)
+    {
+        static_assert(::NsLib::TypeTraits<DataType>::IsTriviallyCopyable::value,
+                      "-- saveSnapshot() requires a trivially copyable DataType");
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+        ::NsLib::ObjectPoolSnapshotHeader header = getSnapshotLayout();
+
+        header.currentCapacity_ = currentCapacity_;
+        header.firstFreeIndex_ = getBlockIndex(firstFreeBlock_);
+
+        encodeFreeList();
+
+        bool succeeded = ::NsLib::ObjectPoolSnapshotFile::write(
+                             fileName, header, alignedMemPtr_,
+                             occupancy_.getWords());
+
+        decodeFreeList();
+
+        return succeeded;
+    }
+
+    /*!
+     * \brief   代替create()，将快照文件映射为Pool的内存，恢复保存时的全部对象。
+     *
+     * \param   fileName - saveSnapshot()写入的文件
+     *
+     * \return  文件不存在、与当前Pool的类型或容量不符、空闲链表已损坏、
+     *          平台不支持时返回false，此时Pool仍处于未创建状态
+     *
+     * \details 以MAP_PRIVATE方式mmap()，不需要逐个重新创建对象，
+     *          页面在第一次访问时才从文件读入，之后的修改不会写回文件。\n
+     *          只需要遍历一次空闲链表把块索引换回指针。
+     *
+     * \note    只支持trivially copyable的类型。\n
+     *          统计计数从零开始。
+     *
+     * \see     saveSnapshot()
+     */
+    bool restoreSnapshot(const char *fileName)
+    {
+        static_assert(::NsLib::TypeTraits<DataType>::IsTriviallyCopyable::value,
+                      "-- restoreSnapshot() requires a trivially copyable DataType");
+        assert(!isCreated()
+               && "-- you have already create the object pool");
+
+        ::NsLib::ObjectPoolSnapshotHeader header = getSnapshotLayout();
+
+        occupancy_.init(capacity_);
+
+        void *slab = ::NsLib::ObjectPoolSnapshotFile::map(
+                         fileName, header, occupancy_.getWords());
+
+        if (nullptr == slab)
+        {
+            occupancy_.release();
+            return false;
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::restoreSnapshot() slab",
+                        slab);
+#endif
+
+        mappedSize_ = header.slabSize_;
+        poolMemPtr_ = (DataType *)(slab);
+        alignedMemPtr_ = poolMemPtr_;
+        currentCapacity_ = header.currentCapacity_;
+        firstFreeBlock_ = getBlock(header.firstFreeIndex_);
+
+        if (!decodeFreeList())
+        {
+            ::NsLib::ObjectPoolSnapshotFile::unmap(poolMemPtr_, mappedSize_);
+
+            mappedSize_ = 0;
+            poolMemPtr_ = nullptr;
+            alignedMemPtr_ = nullptr;
+            occupancy_.release();
+
+            return false;
+        }
+
+        counters_.init(mappedSize_);
+
+        return true;
+    }
+
+    bool isCreated()
+    {
+        return nullptr == alignedMemPtr_ ? false : true;
+    }
+
+    bool isDestroyed()
+    {
+        return nullptr == poolMemPtr_ ? true: false;
+    }
+
+    bool hasFreeBlock() const
+    {
+        return 0 < currentCapacity_;
+    }
+
+    bool isMemoryLocked() const
+    {
+        return memoryLocked_;
+    }
+
+    bool isPointerValid(DataType *ptr)
+    {
+        char *lastBlock = (char *)(alignedMemPtr_) + dataSize_ * (capacity_ - 1);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::isPointerValid() object pool end Address",
+                        (void *)(lastBlock));
+#endif
+
+        return (nullptr != ptr
+                && alignedMemPtr_ <= ptr
+                && (char *)(ptr) <= lastBlock);
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    // 为了内存访问效率, 内存分配要满足数据类型内存对齐的需要,
+    // 这里经过一些trick来实现可移植的分配手段
+    void init(unsigned int prefaultMode)
+    {
+#ifdef _NS_DEBUG_
+        NS_DEBUG_MESSAGE_4("ObjectPool<",
+                           typeid(DataType).name(),
+                           ">::init() sizeof(DataType): ",
+                           sizeof(DataType));
+        NS_DEBUG_MESSAGE_4("ObjectPool<",
+                           typeid(DataType).name(),
+                           ">::init() dataSize_: ",
+                           dataSize_);
+        NS_DEBUG_MESSAGE_4("ObjectPool<",
+                           typeid(DataType).name(),
+                           ">::init() alignof(DataType): ",
+                           alignof(DataType));
+        NS_DEBUG_MESSAGE_4("ObjectPool<",
+                           typeid(DataType).name(),
+                           ">::init() slotAlignment_: ",
+                           slotAlignment_);
+#endif
+
+        // 多分配一个dataSize_大小, 因为后面的算法需要在分配了capacity_个对象后,
+        // 有一个dataSize_大小保存firstFreeBlock_指针
+        size_t size = getPoolMemorySize();
+
+#ifdef _NS_DEBUG_
+        NS_DEBUG_MESSAGE_4("ObjectPool<",
+                           typeid(DataType).name(),
+                           ">::init() size: ",
+                           size);
+#endif
+
+        poolMemPtr_ = PoolAllocator::allocate(size);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::init() poolMemPtr",
+                        poolMemPtr_);
+#endif
+
+        // 必须在建立空闲链表之前, 逐页写入会覆盖块中的内容
+        if (0 != (prefaultMode & ::NsLib::ObjectPoolPrefault::Touch))
+        {
+            ::NsLib::ObjectPoolPrefaulter::touch(
+                (char *)(poolMemPtr_),
+                size,
+                0 != (prefaultMode & ::NsLib::ObjectPoolPrefault::Parallel));
+        }
+
+        if (0 != (prefaultMode & ::NsLib::ObjectPoolPrefault::Lock))
+        {
+            memoryLocked_ = ::NsLib::ObjectPoolPrefaulter::lock(
+                                (char *)(poolMemPtr_), size);
+        }
+
+        alignedMemPtr_ = (DataType *)(
+            ((uintptr_t)(poolMemPtr_) + slotAlignment_ - 1)
+            & (uintptr_t)(~(slotAlignment_ - 1)));
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::init() alignedMemPtr_",
+                        alignedMemPtr_);
+#endif
+
+        firstFreeBlock_ = (FreeBlockNode *)(alignedMemPtr_);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::init() firstFreeBlock_",
+                        firstFreeBlock_);
+#endif
+
+        firstFreeBlock_->pNext_ = nullptr;
+        occupancy_.init(capacity_);
+        counters_.init(size);
+
+        currentCapacity_ = capacity_;
+    }
+
+    DataType *getMemoryBlock()
+    {
+        FreeBlockNode *object = firstFreeBlock_;
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getMemoryBlock() object",
+                        object);
+#endif
+
+        // 这里维护的是空闲节点的数目, 即Pool的剩余容量
+        --currentCapacity_;
+
+        if (0 == firstFreeBlock_->pNext_)
+        {
+            firstFreeBlock_ = (FreeBlockNode *)(
+                (char *)(firstFreeBlock_) + dataSize_);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+            NS_TRACE_MEMORY("ObjectPool<",
+                            typeid(DataType).name(),
+                            ">::getMemoryBlock() firstFreeBlock_",
+                            firstFreeBlock_);
+#endif
+
+            firstFreeBlock_->pNext_ = nullptr;
+        }
+        else
+        {
+            firstFreeBlock_ = firstFreeBlock_->pNext_;
+        }
+
+        if (hasOccupancyBitmap_)
+        {
+            occupancy_.set(getBlockIndex(object));
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onAllocate(1, capacity_ - currentCapacity_);
+        }
+
+        return static_cast<DataType *>(reinterpret_cast<void *>(object));
+    }
+
+    void returnMemoryBlock(FreeBlockNode *objectBlock)
+    {
 #ifdef _NS_DEBUG_TRACE_MEMORRY_
         NS_TRACE_MEMORY("ObjectPool<",
                         typeid(DataType).name(),
-                        ">::init() alignedMemPtr_",
-                        alignedMemPtr_);
+                        ">::returnMemoryBlock() objectBlock",
+                        objectBlock);
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::returnMemoryBlock() firstFreeBlock_",
+                        firstFreeBlock_);
 #endif
 
-        firstFreeBlock_ = (FreeBlockNode *)(alignedMemPtr_);
+        if (hasOccupancyBitmap_)
+        {
+            assert(occupancy_.test(getBlockIndex(objectBlock))
+                   && "-- the object has already been deleted");
+
+            occupancy_.clear(getBlockIndex(objectBlock));
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onFree(1);
+        }
+
+        objectBlock->pNext_ = firstFreeBlock_;
+        firstFreeBlock_ = objectBlock;
 
 #ifdef _NS_DEBUG_TRACE_MEMORRY_
         NS_TRACE_MEMORY("ObjectPool<",
                         typeid(DataType).name(),
-                        ">::init() firstFreeBlock_",
+                        ">::returnMemoryBlock() firstFreeBlock_ after adjust: ",
+                        firstFreeBlock_);
+#endif
+
+        ++currentCapacity_;
+    }
+
+    void getMemoryBlocks(size_t count, DataType **objectPtrs)
+    {
+        FreeBlockNode *block = firstFreeBlock_;
+        size_t i = 0;
+
+        currentCapacity_ -= count;
+
+        // 回收过的块, 只有未分配区域的第一个块pNext_为nullptr
+        while (i < count && nullptr != block->pNext_)
+        {
+            objectPtrs[i++] = (DataType *)(block);
+            block = block->pNext_;
+        }
+
+        // 剩余的块在未分配区域中是连续的, 一次划出
+        if (i < count)
+        {
+            char *memPtr = (char *)(block);
+
+            for (; i < count; ++i, memPtr += dataSize_)
+            {
+                objectPtrs[i] = (DataType *)(memPtr);
+            }
+
+            block = (FreeBlockNode *)(memPtr);
+            block->pNext_ = nullptr;
+        }
+
+        firstFreeBlock_ = block;
+
+        if (hasOccupancyBitmap_)
+        {
+            for (size_t j = 0; j < count; ++j)
+            {
+                occupancy_.set(getBlockIndex((FreeBlockNode *)(objectPtrs[j])));
+            }
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onAllocate(count, capacity_ - currentCapacity_);
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getMemoryBlocks() firstFreeBlock_",
+                        firstFreeBlock_);
+#endif
+    }
+
+    void returnMemoryBlocks(DataType **objectPtrs, size_t count)
+    {
+        if (0 == count)
+        {
+            return;
+        }
+
+        if (hasOccupancyBitmap_)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t index = getBlockIndex((FreeBlockNode *)(objectPtrs[i]));
+
+                assert(occupancy_.test(index)
+                       && "-- the object has already been deleted");
+
+                occupancy_.clear(index);
+            }
+        }
+
+        if (hasStatistics_)
+        {
+            counters_.onFree(count);
+        }
+
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            ((FreeBlockNode *)(objectPtrs[i]))->pNext_ =
+                (FreeBlockNode *)(objectPtrs[i + 1]);
+        }
+
+        ((FreeBlockNode *)(objectPtrs[count - 1]))->pNext_ = firstFreeBlock_;
+        firstFreeBlock_ = (FreeBlockNode *)(objectPtrs[0]);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ObjectPool<",
+                        typeid(DataType).name(),
+                        ">::returnMemoryBlocks() firstFreeBlock_",
                         firstFreeBlock_);
 #endif
 
-        firstFreeBlock_->pNext_ = nullptr;
+        currentCapacity_ += count;
+    }
+
+    static void destroyObject(DataType *, ::NsLib::True_)
+    {
+    }
+
+    static void destroyObject(DataType *objectPtr, ::NsLib::False_)
+    {
+        objectPtr->~DataType();
+    }
+
+    static void destroyObjects(DataType **, size_t, ::NsLib::True_)
+    {
+    }
+
+    static void destroyObjects(DataType **objectPtrs,
+                               size_t count,
+                               ::NsLib::False_)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            objectPtrs[i]->~DataType();
+        }
+    }
+
+    void destroyLiveObjects(::NsLib::True_)
+    {
+    }
+
+    void destroyLiveObjects(::NsLib::False_)
+    {
+        if (hasOccupancyBitmap_)
+        {
+            forEachLiveObject([](DataType &object) { object.~DataType(); });
+            return;
+        }
+
+        std::vector<bool> isFree;
+        size_t unusedIndex = markFreeBlocks(isFree);
+
+        for (size_t i = 0; i < unusedIndex; ++i)
+        {
+            if (!isFree[i])
+            {
+                ((DataType *)((char *)(alignedMemPtr_) + dataSize_ * i))
+                    ->~DataType();
+            }
+        }
+    }
+
+    // 标记空闲链表中的块, 返回未分配区域的第一个块的索引,
+    // 在它之前没有被标记的块都是存活对象
+    size_t markFreeBlocks(std::vector<bool> &isFree)
+    {
+        FreeBlockNode *block = firstFreeBlock_;
+
+        isFree.assign(capacity_ + 1, false);
+
+        while (nullptr != block->pNext_)
+        {
+            isFree[getBlockIndex(block)] = true;
+            block = block->pNext_;
+        }
+
+        return getBlockIndex(block);
+    }
+
+    // 释放[first, last)中完整的页, 返回释放的字节数
+    size_t releasePages(char *first, char *last)
+    {
+#if defined(__linux__) && defined(MADV_DONTNEED)
+        uintptr_t pageSize = (uintptr_t)(sysconf(_SC_PAGESIZE));
+        uintptr_t firstPage = ((uintptr_t)(first) + pageSize - 1)
+                              & ~(pageSize - 1);
+        uintptr_t lastPage = (uintptr_t)(last) & ~(pageSize - 1);
+
+        if (memoryLocked_
+            || lastPage <= firstPage
+            || 0 != madvise((void *)(firstPage),
+                            lastPage - firstPage,
+                            MADV_DONTNEED))
+        {
+            return 0;
+        }
+
+        return lastPage - firstPage;
+#else
+        (void)(first);
+        (void)(last);
+
+        return 0;
+#endif
+    }
+
+    // init()中向Allocator申请的字节数
+    size_t getPoolMemorySize() const
+    {
+        return dataSize_ * (capacity_ + 1) + slotAlignment_;
+    }
+
+    size_t getBlockIndex(FreeBlockNode *block)
+    {
+        return ((char *)(block) - (char *)(alignedMemPtr_)) / dataSize_;
+    }
+
+    // 快照文件头中与Pool布局有关的字段
+    ::NsLib::ObjectPoolSnapshotHeader getSnapshotLayout() const
+    {
+        ::NsLib::ObjectPoolSnapshotHeader header = {};
+
+        header.magic_ = ::NsLib::ObjectPoolSnapshotFile::magic_;
+        header.version_ = ::NsLib::ObjectPoolSnapshotFile::version_;
+        header.dataSize_ = dataSize_;
+        header.capacity_ = capacity_;
+        header.slabSize_ = dataSize_ * (capacity_ + 1);
+        header.occupancyWordCount_ = hasOccupancyBitmap_
+                                     ? (capacity_ + 63) / 64
+                                     : 0;
+        header.pageSize_ = ::NsLib::ObjectPoolSnapshotFile::getPageSize();
+
+        return header;
+    }
+
+    FreeBlockNode *getBlock(size_t index)
+    {
+        return (FreeBlockNode *)((char *)(alignedMemPtr_) + dataSize_ * index);
+    }
+
+    // 空闲链表中的指针改为块索引 + 1, nullptr保持不变
+    void encodeFreeList()
+    {
+        FreeBlockNode *block = firstFreeBlock_;
+
+        while (nullptr != block->pNext_)
+        {
+            FreeBlockNode *next = block->pNext_;
+
+            block->pNext_ = (FreeBlockNode *)(getBlockIndex(next) + 1);
+            block = next;
+        }
+    }
+
+    // 索引越界或链表长度超过容量(成环)时返回false,
+    // 损坏的快照文件不能使空闲链表指向块区域之外
+    bool decodeFreeList()
+    {
+        FreeBlockNode *block = firstFreeBlock_;
+        size_t remaining = capacity_;
+
+        while (nullptr != block->pNext_)
+        {
+            size_t index = (size_t)(block->pNext_) - 1;
+
+            if (capacity_ < index || 0 == remaining--)
+            {
+                return false;
+            }
+
+            block->pNext_ = getBlock(index);
+            block = block->pNext_;
+        }
+
+        return true;
+    }
+
+    template <typename Function>
+    void forEachLiveObject(Function function)
+    {
+        char *memPtr = (char *)(alignedMemPtr_);
+        size_t dataSize = dataSize_;
+
+        occupancy_.forEach([=](size_t index)
+        {
+            function(*(DataType *)(memPtr + dataSize * index));
+        });
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    size_t               capacity_;
+    size_t               dataSize_;
+    size_t               currentCapacity_;
+    DataType             *poolMemPtr_;      // 实际分配内存首地址, 用于释放
+    DataType             *alignedMemPtr_;   // 满足内存对齐要求的首地址
+    FreeBlockNode        *firstFreeBlock_;  // 第一个未分配结点
+    Occupancy            occupancy_;        // 存活块位图, 未开启时为空
+    Counters             counters_;         // 统计计数, 未开启时为空
+    bool                 memoryLocked_;     // create()时是否成功mlock()
+    size_t               mappedSize_;       // 由快照文件映射时的字节数, 否则为0
+};
+
+/*!
+ * \brief   将对象归还给Object Pool的删除器，没有任何状态。
+ * \ingroup NsPool
+ *
+ * \tparam  PoolName - ObjectPool名称
+ *
+ * \details std::unique_ptr<DataType, ObjectPoolDeleter<PoolName> >的大小与
+ *          DataType *相同。
+ *
+ * \see     ObjectPool::emplace()
+ */
+template <typename PoolName>
+struct ObjectPoolDeleter
+{
+    void operator ()(typename PoolName::DataType_ *objectPtr) const
+    {
+        PoolName::deleteObject(objectPtr);
+    }
+};
+
+/*!
+ * \internal
+ * \brief   通用Object Pool。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
+ *
+ * \details 本Object Pool默认容量为1000，超出1000在debug模式下会触发断言。\n
+ *          默认使用的是UserDefaultAllocator内存分配器，如果对内存分配有特殊需求，
+ *          请根据UserDefaultAllocator接口自定义内存分配器。\n
+ *          每一组<DataType, capacity, Allocator>对应一个全局的LocalObjectPool实例，
+ *          所有操作都转发给该实例。
+ *
+ * \note    对于内置数据类型(char ,int, double...)请使用Memory Pool，使用Object Pool
+ *          并不能提升效率。
+ *
+ * \note    默认内存配置器接口。
+ *
+ * \see     UserDefaultAllocator \n
+ *          LocalObjectPool
+ *
+ * \note    不要直接使用ObjectPool类，请使用为ObjectPool提供的宏进行操作。
+ *
+ * \see     NS_DEFINE_OBJECT_POOL_NAME \n
+ *          NS_CREATE_OBJECT_POOL      \n
+ *          NS_NEW_FROM_OBJECT_POOL    \n
+ *          NS_DELETE_IN_OBJECT_POOL   \n
+ *          NS_DESTROY_OBJECT_POOL
+ * \endinternal
+ */
+template <typename      DataType,
+          size_t        capacity = 1000,
+          template      <typename>
+                        class Allocator = ::NsLib::UserDefaultAllocator,
+          unsigned int  options = ::NsLib::ObjectPoolOption::Default>
+class ObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(ObjectPool);
+
+    // operator new[]需要从Pool中划出连续的块
+    template <typename, size_t, template <typename> class>
+    friend class ::NsLib::INewFromObjectPool;
+
+    typedef ::NsLib::LocalObjectPool<DataType, capacity, Allocator, options>
+            PoolInstance;
+
+public:
+    // NS_NEW_FROM_OBJECT_POOL等宏需要访问
+    typedef DataType            DataType_;
+
+    // emplace()返回的智能指针, 大小与DataType *相同
+    typedef std::unique_ptr<DataType, ::NsLib::ObjectPoolDeleter<ObjectPool> >
+            UniquePtr_;
+
+    /*!
+     * \internal
+     * \brief   创建Object Pool，分配所需内存。
+     *
+     * \throw   bad_alloc
+     *
+     * \see     LocalObjectPool::create()
+     * \endinternal
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        getInstance().create();
+    }
+
+    /*!
+     * \internal
+     * \see     LocalObjectPool::create(unsigned int)
+     * \endinternal
+     */
+    static void create(unsigned int prefaultMode) NS_THROW(std::bad_alloc)
+    {
+        getInstance().create(prefaultMode);
+    }
+
+    /*!
+     * \internal
+     * \brief   销毁Object Pool，并释放所有分配的内存。
+     *
+     * \note    Debug模式下如果没有创建Pool而直接调用此函数，或者多次调用，会触发断言。
+     *
+     * \see     LocalObjectPool::destroy()
+     * \endinternal
+     */
+    static void destroy()
+    {
+        getInstance().destroy();
+    }
+
+    static DataType *getObjectMemory()
+    {
+        return getInstance().getObjectMemory();
     }
 
-    bool isCreated()
+    static void deleteObject(DataType *objectPtr)
     {
-        return nullptr == alignedMemPtr_ ? false : true;
+        getInstance().deleteObject(objectPtr);
     }
 
-    bool isDestroyed()
+    static void deallocateMemory(DataType *objectPtr)
     {
-        return nullptr == poolMemPtr_ ? true: false;
+        getInstance().deallocateMemory(objectPtr);
     }
 
-    bool isPointerValid(DataType *ptr)
+    /*!
+     * \internal
+     * \see     LocalObjectPool::construct()
+     * \endinternal
+     */
+    template <typename... Args>
+    static DataType *construct(Args&&... args)
     {
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::isPointerValid() object pool end Address",
-                        (alignedMemPtr_ + capacity_ - 1));
-#endif
+        return getInstance().construct(std::forward<Args>(args)...);
+    }
 
-        return (nullptr != ptr
-                && alignedMemPtr_ <= ptr
-                && ptr <= (alignedMemPtr_ + capacity_ - 1));
+    /*!
+     * \internal
+     * \brief   分配并构造对象，返回拥有该对象的unique_ptr。
+     *
+     * \details 析构时通过ObjectPoolDeleter调用deleteObject()，
+     *          构造函数抛出异常时块会归还给Pool。
+     *
+     * \see     NS_EMPLACE_IN_OBJECT_POOL
+     * \endinternal
+     */
+    template <typename... Args>
+    static UniquePtr_ emplace(Args&&... args)
+    {
+        return UniquePtr_(construct(std::forward<Args>(args)...));
     }
 
-    DataType *getMemoryBlock()
+    /*!
+     * \internal
+     * \see     LocalObjectPool::getObjectMemoryBatch()
+     * \endinternal
+     */
+    static void getObjectMemoryBatch(size_t count, DataType **objectPtrs)
     {
-        FreeBlockNode *object = firstFreeBlock_;
+        getInstance().getObjectMemoryBatch(count, objectPtrs);
+    }
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::getMemoryBlock() object",
-                        object);
-#endif
+    /*!
+     * \internal
+     * \see     LocalObjectPool::deleteObjectBatch()
+     * \endinternal
+     */
+    static void deleteObjectBatch(DataType **objectPtrs, size_t count)
+    {
+        getInstance().deleteObjectBatch(objectPtrs, count);
+    }
 
-        // 这里维护的是空闲节点的数目, 即Pool的剩余容量
-        --currentCapacity_;
+    static void deallocateMemoryBatch(DataType **objectPtrs, size_t count)
+    {
+        getInstance().deallocateMemoryBatch(objectPtrs, count);
+    }
 
-        if (0 == firstFreeBlock_->pNext_)
-        {
-            firstFreeBlock_ = (FreeBlockNode *)(
-                (char *)(firstFreeBlock_) + dataSize_);
+    /*!
+     * \internal
+     * \see     LocalObjectPool::reset()
+     * \endinternal
+     */
+    static void reset()
+    {
+        getInstance().reset();
+    }
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-            NS_TRACE_MEMORY("ObjectPool<",
-                            typeid(DataType).name(),
-                            ">::getMemoryBlock() firstFreeBlock_",
-                            firstFreeBlock_);
-#endif
+    /*!
+     * \internal
+     * \see     LocalObjectPool::resetAndDestroyObjects()
+     * \endinternal
+     */
+    static void resetAndDestroyObjects()
+    {
+        getInstance().resetAndDestroyObjects();
+    }
 
-            firstFreeBlock_->pNext_ = nullptr;
-        }
-        else
-        {
-            firstFreeBlock_ = firstFreeBlock_->pNext_;
-        }
+    /*!
+     * \internal
+     * \see     LocalObjectPool::compact()
+     * \endinternal
+     */
+    template <typename RelocationCallback>
+    static size_t compact(RelocationCallback callback)
+    {
+        return getInstance().compact(callback);
+    }
 
-        return static_cast<DataType *>(reinterpret_cast<void *>(object));
+    static size_t compact()
+    {
+        return getInstance().compact();
     }
 
-    void returnMemoryBlock(FreeBlockNode *objectBlock)
+    /*!
+     * \internal
+     * \see     LocalObjectPool::trim()
+     * \endinternal
+     */
+    static size_t trim()
     {
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::returnMemoryBlock() objectBlock",
-                        objectBlock);
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::returnMemoryBlock() firstFreeBlock_",
-                        firstFreeBlock_);
-#endif
+        return getInstance().trim();
+    }
 
-        objectBlock->pNext_ = firstFreeBlock_;
-        firstFreeBlock_ = objectBlock;
+    /*!
+     * \internal
+     * \see     LocalObjectPool::forEachLive()
+     * \endinternal
+     */
+    template <typename Function>
+    static void forEachLive(Function function)
+    {
+        getInstance().forEachLive(function);
+    }
 
-#ifdef _NS_DEBUG_TRACE_MEMORRY_
-        NS_TRACE_MEMORY("ObjectPool<",
-                        typeid(DataType).name(),
-                        ">::returnMemoryBlock() firstFreeBlock_ after adjust: ",
-                        firstFreeBlock_);
-#endif
+    /*!
+     * \internal
+     * \see     LocalObjectPool::getStatistics()
+     * \endinternal
+     */
+    static ::NsLib::ObjectPoolStatistics getStatistics()
+    {
+        return getInstance().getStatistics();
+    }
 
-        ++currentCapacity_;
+    /*!
+     * \internal
+     * \see     LocalObjectPool::saveSnapshot()
+     * \endinternal
+     */
+    static bool saveSnapshot(const char *fileName)
+    {
+        return getInstance().saveSnapshot(fileName);
+    }
+
+    /*!
+     * \internal
+     * \see     LocalObjectPool::restoreSnapshot()
+     * \endinternal
+     */
+    static bool restoreSnapshot(const char *fileName)
+    {
+        return getInstance().restoreSnapshot(fileName);
     }
 
 // 如果需要调试信息, 则需要获取内部状态, 这里要使用public
@@ -439,12 +2387,29 @@ private:
 public:
 #endif
 
-    size_t               capacity_;
-    size_t               dataSize_;
-    size_t               currentCapacity_;
-    DataType             *poolMemPtr_;      // 实际分配内存首地址, 用于释放
-    DataType             *alignedMemPtr_;   // 满足内存对齐要求的首地址
-    FreeBlockNode        *firstFreeBlock_;  // 第一个未分配结点
+    ObjectPool() = delete;
+
+    static PoolInstance &getInstance()
+    {
+        static PoolInstance poolInstance;
+
+        return poolInstance;
+    }
+
+    static void *getContiguousMemory(size_t size)
+    {
+        return getInstance().getContiguousMemory(size);
+    }
+
+    static void deallocateContiguousMemory(void *memPtr, size_t size)
+    {
+        getInstance().deallocateContiguousMemory(memPtr, size);
+    }
+
+    static bool isPointerValid(DataType *ptr)
+    {
+        return getInstance().isPointerValid(ptr);
+    }
 };
 
 /*!
@@ -455,6 +2420,7 @@ public:
  * \param   存储的数据类型
  * \param   [可选]容量[默认=1000]
  * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ * \param   [可选]ObjectPoolOption的组合[默认=Default]
  *
  * \details 定义Object Pool名称，用于区分不同Object Pool。
  *
@@ -473,6 +2439,13 @@ public:
  *
  * // 定义容量为2000，内存分配器为MyAllocator，存储MyClass类型的Object Pool。
  * NS_DEFINE_OBJECT_POOL_NAME(MyClassPool, MyClass, 2000, MyAllocator);
+ *
+ * // 开启存活块位图，可以使用MyClassPool::forEachLive()遍历所有存活对象。
+ * NS_DEFINE_OBJECT_POOL_NAME(MyClassPool,
+ *                            MyClass,
+ *                            2000,
+ *                            ::NsLib::UserDefaultAllocator,
+ *                            ::NsLib::ObjectPoolOption::OccupancyBitmap);
  * \endcode
  *
  * \note    以下宏依赖此处定义的Object Pool名称：
@@ -518,6 +2491,31 @@ public:
 #define NS_CREATE_OBJECT_POOL(PoolName) \
     PoolName::create()
 
+/*!
+ * \brief   创建Object Pool，并预先完成缺页中断，可选锁定内存。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   prefaultMode - ObjectPoolPrefault的组合
+ *
+ * \details 用于对帧时间敏感的场景，避免第一局中首次使用每个块时的缺页中断。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_OBJECT_POOL_NAME(ProjectilePool, Projectile, 1000000);
+ *
+ * // 创建时逐页写入并mlock()，大Pool使用多线程并行写入。
+ * NS_CREATE_PREFAULTED_OBJECT_POOL(ProjectilePool,
+ *                                  ::NsLib::ObjectPoolPrefault::Touch
+ *                                  | ::NsLib::ObjectPoolPrefault::Lock
+ *                                  | ::NsLib::ObjectPoolPrefault::Parallel);
+ * \endcode
+ *
+ * \see     NS_CREATE_OBJECT_POOL
+ */
+#define NS_CREATE_PREFAULTED_OBJECT_POOL(PoolName, prefaultMode) \
+    PoolName::create(prefaultMode)
+
 /*!
  * \brief   从指定的Object Pool中分配对象。
  * \ingroup NsPool
@@ -609,6 +2607,92 @@ public:
 #define NS_DELETE_IN_OBJECT_POOL(PoolName, objectPtr) \
     PoolName::deleteObject(objectPtr)
 
+/*!
+ * \brief   从指定的Object Pool中分配对象，返回拥有该对象的unique_ptr。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   [可选]构造对象所需参数[参数数量不受限制]，完美转发给构造函数
+ *
+ * \details 返回PoolName::UniquePtr_，离开作用域时自动调用NS_DELETE_IN_OBJECT_POOL，
+ *          删除器没有状态，智能指针的大小与裸指针相同。\n
+ *          构造函数抛出异常时，块会归还给Pool，不会泄漏。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_OBJECT_POOL_NAME(MyClassPool, MyClass);
+ * NS_CREATE_OBJECT_POOL(MyClassPool);
+ *
+ * MyClassPool::UniquePtr_ myClass = NS_EMPLACE_IN_OBJECT_POOL(MyClassPool, 1, 2);
+ * \endcode
+ *
+ * \see     NS_NEW_FROM_OBJECT_POOL
+ */
+#define NS_EMPLACE_IN_OBJECT_POOL(PoolName, ...) \
+    PoolName::emplace(__VA_ARGS__)
+
+/*!
+ * \brief   从指定的Object Pool中一次分配多个对象。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   count - 要分配的个数
+ * \param   objectPtrs - 保存对象指针的数组，至少能容纳count个指针
+ * \param   [可选]构造对象所需参数[参数数量不受限制]，所有对象使用相同的参数构造
+ *
+ * \details 与调用count次NS_NEW_FROM_OBJECT_POOL的结果相同，但空闲链表只调整一次。\n
+ *          删除对象可以使用NS_DELETE_BATCH_IN_OBJECT_POOL，也可以逐个使用
+ *          NS_DELETE_IN_OBJECT_POOL。
+ *
+ * \note    在Debug模式下，若剩余容量不足count，会触发断言。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_OBJECT_POOL_NAME(PelletPool, Pellet, 10000);
+ * NS_CREATE_OBJECT_POOL(PelletPool);
+ *
+ * Pellet *pellets[200];
+ *
+ * // 一次分配200个对象，都使用Pellet(origin)构造。
+ * NS_NEW_BATCH_FROM_OBJECT_POOL(PelletPool, 200, pellets, origin);
+ *
+ * // 一次删除200个对象。
+ * NS_DELETE_BATCH_IN_OBJECT_POOL(PelletPool, pellets, 200);
+ * \endcode
+ *
+ * \see     NS_DELETE_BATCH_IN_OBJECT_POOL
+ */
+#define NS_NEW_BATCH_FROM_OBJECT_POOL(PoolName, count, objectPtrs, ...)       \
+    do                                                                         \
+    {                                                                          \
+        size_t nsBatchCount_ = (count);                                        \
+        PoolName::getObjectMemoryBatch(nsBatchCount_, (objectPtrs));           \
+        for (size_t nsBatchIndex_ = 0;                                         \
+             nsBatchIndex_ < nsBatchCount_;                                    \
+             ++nsBatchIndex_)                                                  \
+        {                                                                      \
+            ::new((objectPtrs)[nsBatchIndex_])                                 \
+                typename PoolName::DataType_(__VA_ARGS__);                     \
+        }                                                                      \
+    } while (0)
+
+/*!
+ * \brief   一次删除指定Object Pool中分配的多个对象。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   objectPtrs - 待删除的对象指针数组
+ * \param   count - 待删除的个数
+ *
+ * \details 会自动调用每个对象的析构函数，然后将所有块一次接回空闲链表。
+ *
+ * \note    在Debug模式下会检测每个待删除的对象指针是否合法。
+ *
+ * \see     NS_NEW_BATCH_FROM_OBJECT_POOL
+ */
+#define NS_DELETE_BATCH_IN_OBJECT_POOL(PoolName, objectPtrs, count) \
+    PoolName::deleteObjectBatch((objectPtrs), (count))
+
 /*!
  * \brief   销毁指定的Object Pool。
  * \ingroup NsPool
@@ -648,6 +2732,85 @@ public:
 #define NS_DESTROY_OBJECT_POOL(PoolName) \
     PoolName::destroy()
 
+/*!
+ * \brief   一次丢弃指定Object Pool中分配的所有对象。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ *
+ * \details 时间复杂度O(1)，不调用析构函数，之前分配的所有指针都将失效。\n
+ *          需要调用析构函数时，请使用NS_RESET_AND_DESTROY_OBJECTS_IN_OBJECT_POOL。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_OBJECT_POOL_NAME(HitRecordPool, HitRecord, 10000);
+ * NS_CREATE_OBJECT_POOL(HitRecordPool);
+ *
+ * // 每局中分配大量对象，不逐个删除...
+ *
+ * // 回合结束时一次丢弃。
+ * NS_RESET_OBJECT_POOL(HitRecordPool);
+ * \endcode
+ *
+ * \see     NS_RESET_AND_DESTROY_OBJECTS_IN_OBJECT_POOL
+ */
+#define NS_RESET_OBJECT_POOL(PoolName) \
+    PoolName::reset()
+
+/*!
+ * \brief   调用所有存活对象的析构函数，然后丢弃指定Object Pool中分配的所有对象。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ *
+ * \see     NS_RESET_OBJECT_POOL
+ */
+#define NS_RESET_AND_DESTROY_OBJECTS_IN_OBJECT_POOL(PoolName) \
+    PoolName::resetAndDestroyObjects()
+
+/*!
+ * \brief   从LocalObjectPool实例中分配对象。
+ * \ingroup NsPool
+ *
+ * \param   poolObject - LocalObjectPool实例
+ * \param   [可选]构造对象所需参数[参数数量不受限制]
+ *
+ * \details 与NS_NEW_FROM_OBJECT_POOL相同，区别在于第一个参数是Pool实例而不是Pool名称。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::LocalObjectPool<MyClass, 100> myClassPool;
+ *
+ * myClassPool.create();
+ *
+ * MyClass *myClass = NS_NEW_FROM_LOCAL_OBJECT_POOL(myClassPool, 1, 2);
+ *
+ * NS_DELETE_IN_LOCAL_OBJECT_POOL(myClassPool, myClass);
+ *
+ * myClassPool.destroy();
+ * \endcode
+ *
+ * \see     LocalObjectPool\n
+ *          NS_DELETE_IN_LOCAL_OBJECT_POOL
+ */
+#define NS_NEW_FROM_LOCAL_OBJECT_POOL(poolObject, ...) \
+    ::new((poolObject).getObjectMemory()) \
+        typename std::remove_reference<decltype(poolObject)>::type::DataType_( \
+            __VA_ARGS__)
+
+/*!
+ * \brief   删除LocalObjectPool实例中分配的对象。
+ * \ingroup NsPool
+ *
+ * \param   poolObject - LocalObjectPool实例
+ * \param   objectPtr - 待删除的对象指针
+ *
+ * \see     LocalObjectPool\n
+ *          NS_NEW_FROM_LOCAL_OBJECT_POOL
+ */
+#define NS_DELETE_IN_LOCAL_OBJECT_POOL(poolObject, objectPtr) \
+    (poolObject).deleteObject(objectPtr)
+
 
 /*!
  * \addtogroup  NsPool
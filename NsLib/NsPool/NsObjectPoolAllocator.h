@@ -0,0 +1,234 @@
+#ifndef NS_OBJECT_POOL_ALLOCATOR_H
+#define	NS_OBJECT_POOL_ALLOCATOR_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   ObjectPoolAllocator NsPool.h
+ * \brief   符合标准库要求的分配器，使基于结点的容器从Object Pool中分配结点。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - 要分配的数据类型，容器会自动rebind到结点类型
+ * \tparam  [可选]size_t capacity - 每种结点类型的Pool容量[默认 = 1000]
+ * \tparam  [可选]Allocator - Pool使用的内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 单个对象的分配(n == 1)交给rebind后结点类型专用的LocalObjectPool，
+ *          Pool在第一次分配时创建；Pool已满或者n > 1时(如unordered_map的桶数组)
+ *          改为使用::operator new。\n
+ *          释放时根据地址是否在Pool中决定归还给Pool还是::operator delete。\n
+ *          适用于std::list, std::map, std::set, std::unordered_map等。
+ *
+ * \note    分配器没有状态，同一结点类型的所有容器共享同一个Pool，
+ *          因此不同容器之间可以任意交换结点。\n
+ *          Pool永不销毁，这样全局容器在程序退出时析构也不会访问已释放的内存。\n
+ *          不是线程安全的，多个线程使用同一结点类型的容器时请自行加锁。
+ *
+ * \code
+ * // 示例：
+ * typedef ::NsLib::ObjectPoolAllocator<std::pair<const int, Session>, 100000>
+ *         SessionAllocator;
+ *
+ * std::map<int, Session, std::less<int>, SessionAllocator> sessions;
+ *
+ * sessions[playerId] = Session(playerId);
+ * \endcode
+ *
+ * \see     LocalObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class ObjectPoolAllocator
+{
+    typedef ::NsLib::LocalObjectPool<DataType, capacity, Allocator>
+            PoolInstance;
+
+public:
+    typedef DataType            value_type;
+    typedef DataType            *pointer;
+    typedef const DataType      *const_pointer;
+    typedef DataType            &reference;
+    typedef const DataType      &const_reference;
+    typedef size_t              size_type;
+    typedef ptrdiff_t           difference_type;
+
+    template <typename OtherType>
+    struct rebind
+    {
+        typedef ObjectPoolAllocator<OtherType, capacity, Allocator> other;
+    };
+
+    ObjectPoolAllocator()
+    {
+    }
+
+    template <typename OtherType>
+    ObjectPoolAllocator(
+        const ObjectPoolAllocator<OtherType, capacity, Allocator> &)
+    {
+    }
+
+    DataType *allocate(size_t n, const void * = nullptr)
+    {
+        if (1 == n)
+        {
+            PoolInstance &pool = getPool();
+
+            if (!pool.isCreated())
+            {
+                pool.create();
+            }
+
+            if (pool.hasFreeBlock())
+            {
+                return pool.getObjectMemory();
+            }
+        }
+
+        return static_cast<DataType *>(::operator new(n * sizeof(DataType)));
+    }
+
+    void deallocate(DataType *ptr, size_t n)
+    {
+        // 只有n > 1的分配时Pool从未创建, 不能检查地址
+        if (1 == n
+            && getPool().isCreated()
+            && getPool().isPointerValid(ptr))
+        {
+            getPool().deallocateMemory(ptr);
+        }
+        else
+        {
+            ::operator delete(static_cast<void *>(ptr));
+        }
+    }
+
+    template <typename ObjectType, typename... Args>
+    void construct(ObjectType *ptr, Args&&... args)
+    {
+        ::new(static_cast<void *>(ptr))
+            ObjectType(std::forward<Args>(args)...);
+    }
+
+    template <typename ObjectType>
+    void destroy(ObjectType *ptr)
+    {
+        ptr->~ObjectType();
+    }
+
+    size_t max_size() const
+    {
+        return std::numeric_limits<size_t>::max() / sizeof(DataType);
+    }
+
+    DataType *address(DataType &object) const
+    {
+        return &object;
+    }
+
+    const DataType *address(const DataType &object) const
+    {
+        return &object;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    // 故意不释放, 见类说明
+    static PoolInstance &getPool()
+    {
+        static PoolInstance *poolInstance = new PoolInstance;
+
+        return *poolInstance;
+    }
+};
+
+template <typename  DataType,
+          typename  OtherType,
+          size_t    capacity,
+          template  <typename>
+                    class Allocator>
+inline bool operator ==(
+    const ObjectPoolAllocator<DataType, capacity, Allocator> &,
+    const ObjectPoolAllocator<OtherType, capacity, Allocator> &)
+{
+    return true;
+}
+
+template <typename  DataType,
+          typename  OtherType,
+          size_t    capacity,
+          template  <typename>
+                    class Allocator>
+inline bool operator !=(
+    const ObjectPoolAllocator<DataType, capacity, Allocator> &,
+    const ObjectPoolAllocator<OtherType, capacity, Allocator> &)
+{
+    return false;
+}
+
+/*!
+ * \brief   创建shared_ptr，对象和引用计数控制块位于同一个Object Pool块中。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - 要创建的对象类型
+ * \tparam  [可选]size_t capacity - 专用Pool的容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 专用Pool使用的内存分配器[默认 = UserDefaultAllocator]
+ * \param   [可选]构造对象所需参数[参数数量不受限制]
+ *
+ * \return  std::shared_ptr<DataType>
+ *
+ * \details 通过std::allocate_shared和ObjectPoolAllocator实现，
+ *          标准库把对象和控制块合并为一个类型，整体作为一个块分配，
+ *          每个对象只需要一次分配，引用计数和数据也在同一个cache line附近。\n
+ *          合并后的类型比DataType大，块来自ObjectPoolAllocator为控制块类型
+ *          维护的专用Pool，它在第一次分配时创建、永不销毁，
+ *          与NS_DEFINE_OBJECT_POOL_NAME定义的任何Pool都无关。
+ *          Pool已满时退化为::operator new。
+ *
+ * \note    最后一个shared_ptr或weak_ptr释放时块才会归还给Pool。\n
+ *          不是线程安全的，多线程条件下请自行加锁，引用计数本身仍然是原子的。
+ *
+ * \code
+ * // 示例：
+ * std::shared_ptr<Session> session =
+ *     ::NsLib::makePooledShared<Session, 10000>(playerId);
+ * \endcode
+ *
+ * \see     ObjectPoolAllocator
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator,
+          typename... Args>
+std::shared_ptr<DataType> makePooledShared(Args&&... args)
+{
+    return std::allocate_shared<DataType>(
+        ::NsLib::ObjectPoolAllocator<DataType, capacity, Allocator>(),
+        std::forward<Args>(args)...);
+}
+
+}   // NsLib
+
+#endif
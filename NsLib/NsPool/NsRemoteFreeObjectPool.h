@@ -0,0 +1,309 @@
+#ifndef NS_REMOTE_FREE_OBJECT_POOL_H
+#define	NS_REMOTE_FREE_OBJECT_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for bad_alloc
+#include <new>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   RemoteFreeObjectPool NsPool.h
+ * \brief   属于一个线程的Object Pool，其他线程删除的对象经由无锁队列归还。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 适用于生产者/消费者模式，例如网络线程创建消息，模拟线程删除消息。\n
+ *          只有拥有者线程可以分配，分配和拥有者自己的删除只操作本地空闲链表，
+ *          不需要任何原子操作。\n
+ *          其他线程删除时，块通过CAS压入远程释放队列，
+ *          队列的链接保存在块本身的FreeBlockNode中，不需要额外内存。\n
+ *          本地空闲链表为空时，拥有者用一次原子exchange取走整个远程队列作为新的本地链表，
+ *          远程队列为空时才从未分配区域中划出新块。\n
+ *          本地状态、远程队列头和只读状态各占一个cache line，
+ *          删除线程与拥有者线程之间没有伪共享。
+ *
+ * \note    create()的调用线程成为拥有者，可以通过bindToCurrentThread()转交，
+ *          转交时原拥有者不能再分配。\n
+ *          容量耗尽时，Debug模式下会触发断言，Release模式下抛出bad_alloc。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::RemoteFreeObjectPool<Message, 100000> messagePool;
+ *
+ * // 网络线程：
+ * messagePool.create();
+ * Message *message = NS_NEW_FROM_LOCAL_OBJECT_POOL(messagePool, packet);
+ * queue.push(message);
+ *
+ * // 模拟线程：
+ * messagePool.deleteObject(queue.pop());
+ * \endcode
+ *
+ * \see     LocalObjectPool \n
+ *          ThreadCachedObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class RemoteFreeObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(RemoteFreeObjectPool);
+
+    typedef Allocator<DataType> PoolAllocator;
+
+    struct FreeBlockNode
+    {
+        FreeBlockNode   *pNext_;
+    };
+
+    static const size_t blockAlignment_ =
+        alignof(DataType) < alignof(FreeBlockNode)
+        ? alignof(FreeBlockNode)
+        : alignof(DataType);
+
+public:
+    typedef DataType    DataType_;
+
+    RemoteFreeObjectPool() :
+        capacity_{capacity},
+        poolMemPtr_{nullptr},
+        alignedMemPtr_{nullptr},
+        owner_{std::thread::id()},
+        firstFreeBlock_{nullptr},
+        nextUnusedBlock_{0},
+        remoteFreeHead_{nullptr}
+    {
+        dataSize_ = sizeof(DataType) < sizeof(FreeBlockNode)
+                    ? sizeof(FreeBlockNode)
+                    : sizeof(DataType);
+        dataSize_ = (dataSize_ + blockAlignment_ - 1) & ~(blockAlignment_ - 1);
+    }
+
+    ~RemoteFreeObjectPool()
+    {
+        if (!isDestroyed())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建Object Pool，调用线程成为拥有者。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!isCreated()
+               && "-- you have already create the object pool");
+
+        poolMemPtr_ = PoolAllocator::allocate(dataSize_ * capacity_
+                                              + blockAlignment_);
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("RemoteFreeObjectPool<",
+                        typeid(DataType).name(),
+                        ">::create() poolMemPtr_",
+                        poolMemPtr_);
+#endif
+
+        alignedMemPtr_ = (char *)(
+            ((uintptr_t)(poolMemPtr_) + blockAlignment_ - 1)
+            & (uintptr_t)(~(blockAlignment_ - 1)));
+
+        firstFreeBlock_ = nullptr;
+        nextUnusedBlock_ = 0;
+        remoteFreeHead_.store(nullptr, std::memory_order_relaxed);
+
+        bindToCurrentThread();
+    }
+
+    /*!
+     * \brief   销毁Object Pool，并释放所有分配的内存。
+     *
+     * \note    请在所有线程都不再删除对象之后调用。
+     */
+    void destroy()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("RemoteFreeObjectPool<",
+                        typeid(DataType).name(),
+                        ">::destroy()",
+                        poolMemPtr_);
+#endif
+
+        PoolAllocator::deallocate(poolMemPtr_);
+
+        poolMemPtr_ = nullptr;
+        alignedMemPtr_ = nullptr;
+    }
+
+    /*!
+     * \brief   将拥有者改为调用线程，例如在主线程中创建，交给工作线程使用。
+     *
+     * \note    转交期间原拥有者不能再分配或删除对象，远程队列中的块不受影响。
+     */
+    void bindToCurrentThread()
+    {
+        owner_.store(std::this_thread::get_id(), std::memory_order_release);
+    }
+
+    /*!
+     * \brief   分配一个块，只能在拥有者线程中调用。
+     *
+     * \throw   bad_alloc
+     */
+    DataType *getObjectMemory()
+    {
+        assert(isCreated()
+               && "-- you have not create a object pool");
+        assert(isOwnerThread()
+               && "-- only the owner thread can allocate from the object pool");
+
+        if (nullptr == firstFreeBlock_)
+        {
+            // 远程队列非空时才进行exchange, 否则只有一次relaxed读
+            if (nullptr != remoteFreeHead_.load(std::memory_order_relaxed))
+            {
+                firstFreeBlock_ = remoteFreeHead_.exchange(
+                                      nullptr, std::memory_order_acquire);
+            }
+            else if (nextUnusedBlock_ < capacity_)
+            {
+                return (DataType *)(alignedMemPtr_
+                                    + dataSize_ * nextUnusedBlock_++);
+            }
+            else
+            {
+                assert(false && "-- the object pool has not enough object");
+                throw std::bad_alloc();
+            }
+        }
+
+        FreeBlockNode *block = firstFreeBlock_;
+
+        firstFreeBlock_ = block->pNext_;
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("RemoteFreeObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getObjectMemory()",
+                        block);
+#endif
+
+        return (DataType *)(block);
+    }
+
+    /*!
+     * \brief   删除对象，会自动调用析构函数，可以在任意线程中调用。
+     */
+    void deleteObject(DataType *objectPtr)
+    {
+        assert(nullptr != objectPtr && "-- objectPtr is nullptr");
+
+        objectPtr->~DataType();
+
+        deallocateMemory(objectPtr);
+    }
+
+    void deallocateMemory(DataType *objectPtr)
+    {
+        assert(isPointerValid(objectPtr)
+               && "-- the object is not allocated from this object pool");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("RemoteFreeObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        FreeBlockNode *block = (FreeBlockNode *)(objectPtr);
+
+        if (isOwnerThread())
+        {
+            block->pNext_ = firstFreeBlock_;
+            firstFreeBlock_ = block;
+            return;
+        }
+
+        // 多个生产者只做压入, 唯一的消费者一次取走整个队列, 不存在ABA问题
+        FreeBlockNode *head = remoteFreeHead_.load(std::memory_order_relaxed);
+
+        do
+        {
+            block->pNext_ = head;
+        } while (!remoteFreeHead_.compare_exchange_weak(
+                     head, block,
+                     std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    bool isOwnerThread() const
+    {
+        return std::this_thread::get_id()
+               == owner_.load(std::memory_order_relaxed);
+    }
+
+    bool isCreated() const
+    {
+        return nullptr == alignedMemPtr_ ? false : true;
+    }
+
+    bool isDestroyed() const
+    {
+        return nullptr == poolMemPtr_ ? true : false;
+    }
+
+    bool isPointerValid(DataType *ptr) const
+    {
+        return (nullptr != ptr
+                && alignedMemPtr_ <= (char *)(ptr)
+                && (char *)(ptr) <= alignedMemPtr_ + dataSize_ * (capacity_ - 1));
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    // 创建后只读, 所有线程都会访问
+    alignas(64) size_t                      capacity_;
+    size_t                                  dataSize_;
+    DataType                                *poolMemPtr_;       // 实际分配内存首地址, 用于释放
+    char                                    *alignedMemPtr_;    // 满足内存对齐要求的首地址
+    std::atomic<std::thread::id>            owner_;             // 拥有者线程
+
+    // 只有拥有者线程访问
+    alignas(64) FreeBlockNode               *firstFreeBlock_;   // 本地空闲链表
+    size_t                                  nextUnusedBlock_;   // 第一个从未分配过的块的索引
+
+    // 其他线程删除时写入
+    alignas(64) std::atomic<FreeBlockNode *> remoteFreeHead_;   // 远程释放队列
+};
+
+}   // NsLib
+
+#endif
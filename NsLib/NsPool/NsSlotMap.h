@@ -0,0 +1,352 @@
+#ifndef NS_SLOT_MAP_H
+#define	NS_SLOT_MAP_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsInternalUse/NsTypeTraits.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   SlotMap NsPool.h
+ * \brief   通过带版本号的句柄访问对象的Object Pool，避免悬空指针。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - 要存储对象的类型
+ * \tparam  [可选]size_t capacity - 容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器[默认 = UserDefaultAllocator]
+ *
+ * \details 与ObjectPool一样在一整块内存中按块分配，空闲块串成链表，
+ *          从未分配过的区域顺序划出。\n
+ *          每个块额外保存一个32位的版本号，奇数表示存活，偶数表示空闲，
+ *          emplace()和deleteObject()各使版本号加一。\n
+ *          句柄为64位，高32位为版本号，低32位为块索引，
+ *          get()只需要一次数组下标和一次版本号比较，
+ *          对象删除后旧句柄会返回nullptr，而不是访问已经被复用的块。\n
+ *          0永远不是合法句柄，可以用invalidHandle_表示空句柄。
+ *
+ * \note    同一个块被复用2^31次后版本号会回绕。\n
+ *          不是线程安全的。
+ *
+ * \code
+ * // 示例：
+ * ::NsLib::SlotMap<Entity, 100000> entities;
+ *
+ * entities.create();
+ *
+ * ::NsLib::SlotMap<Entity, 100000>::Handle player = entities.emplace(name);
+ *
+ * // 实体可能已经被其他系统删除。
+ * if (Entity *entity = entities.get(player))
+ * {
+ *      entity->update();
+ * }
+ *
+ * entities.deleteObject(player);
+ * entities.destroy();
+ * \endcode
+ *
+ * \see     LocalObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator>
+class SlotMap
+{
+    MAKE_CLASS_UNCOPYABLE(SlotMap);
+
+    static_assert(0 < capacity && capacity < UINT32_MAX,
+                  "-- capacity of SlotMap must fit in 32 bits");
+
+    // 版本号在前, 访问对象时通常与对象位于同一个cache line
+    struct Slot
+    {
+        uint32_t    generation_;
+        uint32_t    nextFree_;      // 空闲时保存下一个空闲块的索引
+        typename std::aligned_storage<sizeof(DataType),
+                                      alignof(DataType)>::type  storage_;
+    };
+
+    typedef Allocator<Slot> SlotAllocator;
+
+    static const uint32_t endOfList_ = UINT32_MAX;
+
+public:
+    typedef DataType    DataType_;
+    typedef uint64_t    Handle;
+
+    static const Handle invalidHandle_ = 0;
+
+    SlotMap() :
+        poolMemPtr_{nullptr},
+        slots_{nullptr},
+        firstFreeSlot_{endOfList_},
+        nextUnusedSlot_{0},
+        size_{0}
+    {
+    }
+
+    ~SlotMap()
+    {
+        if (isCreated())
+        {
+            destroy();
+        }
+    }
+
+    /*!
+     * \brief   创建SlotMap，分配所需内存。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    void create() NS_THROW(std::bad_alloc)
+    {
+        assert(!isCreated()
+               && "-- you have already create the slot map");
+
+        poolMemPtr_ = SlotAllocator::allocate(
+            sizeof(Slot) * capacity + alignof(Slot));
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("SlotMap<",
+                        typeid(DataType).name(),
+                        ">::create() poolMemPtr_",
+                        poolMemPtr_);
+#endif
+
+        slots_ = (Slot *)(
+            ((uintptr_t)(poolMemPtr_) + alignof(Slot) - 1)
+            & (uintptr_t)(~(alignof(Slot) - 1)));
+
+        firstFreeSlot_ = endOfList_;
+        nextUnusedSlot_ = 0;
+        size_ = 0;
+    }
+
+    /*!
+     * \brief   销毁SlotMap，调用所有存活对象的析构函数并释放内存。
+     *
+     * \note    所有句柄随之失效。
+     */
+    void destroy()
+    {
+        assert(isCreated()
+               && "-- you have not create a slot map");
+
+        if (!::NsLib::TypeTraits<DataType>::HasTrivialDestructor::value)
+        {
+            for (uint32_t i = 0; i < nextUnusedSlot_; ++i)
+            {
+                if (isLive(slots_[i]))
+                {
+                    getObject(slots_[i])->~DataType();
+                }
+            }
+        }
+
+        SlotAllocator::deallocate(poolMemPtr_);
+
+        poolMemPtr_ = nullptr;
+        slots_ = nullptr;
+    }
+
+    /*!
+     * \brief   分配对象并用args构造，返回对象的句柄。
+     *
+     * \param   [可选]args - 构造对象所需参数，完美转发给构造函数
+     *
+     * \return  句柄
+     *
+     * \details 构造函数抛出异常时，块归还给SlotMap，版本号不变。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    容量不足时，Debug模式下会触发断言，Release模式下抛出bad_alloc。
+     */
+    template <typename... Args>
+    Handle emplace(Args&&... args)
+    {
+        assert(isCreated()
+               && "-- you have not create a slot map");
+
+        uint32_t index = getFreeSlot();
+        Slot &slot = slots_[index];
+
+        try
+        {
+            ::new((void *)(&slot.storage_)) DataType(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            returnSlot(index);
+            throw;
+        }
+
+        ++slot.generation_;
+        ++size_;
+
+        return makeHandle(index, slot.generation_);
+    }
+
+    /*!
+     * \brief   获得句柄对应的对象。
+     *
+     * \param   handle - emplace()返回的句柄
+     *
+     * \return  对象指针，对象已经被删除或句柄非法时返回nullptr
+     */
+    DataType *get(Handle handle)
+    {
+        uint32_t index = getIndex(handle);
+
+        if (index < nextUnusedSlot_
+            && slots_[index].generation_ == getGeneration(handle)
+            && 0 != (getGeneration(handle) & 1))
+        {
+            return getObject(slots_[index]);
+        }
+
+        return nullptr;
+    }
+
+    const DataType *get(Handle handle) const
+    {
+        return const_cast<SlotMap *>(this)->get(handle);
+    }
+
+    bool isValid(Handle handle) const
+    {
+        return nullptr != get(handle);
+    }
+
+    /*!
+     * \brief   删除句柄对应的对象，会自动调用析构函数。
+     *
+     * \param   handle - emplace()返回的句柄
+     *
+     * \return  对象已经被删除或句柄非法时返回false
+     *
+     * \details 块的版本号加一，所有指向该对象的旧句柄随之失效。
+     */
+    bool deleteObject(Handle handle)
+    {
+        DataType *objectPtr = get(handle);
+
+        if (nullptr == objectPtr)
+        {
+            return false;
+        }
+
+        objectPtr->~DataType();
+
+        uint32_t index = getIndex(handle);
+
+        ++slots_[index].generation_;
+        --size_;
+        returnSlot(index);
+
+        return true;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool isCreated() const
+    {
+        return nullptr == slots_ ? false : true;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    static Handle makeHandle(uint32_t index, uint32_t generation)
+    {
+        return ((Handle)(generation) << 32) | index;
+    }
+
+    static uint32_t getIndex(Handle handle)
+    {
+        return (uint32_t)(handle & 0xFFFFFFFFull);
+    }
+
+    static uint32_t getGeneration(Handle handle)
+    {
+        return (uint32_t)(handle >> 32);
+    }
+
+    static bool isLive(const Slot &slot)
+    {
+        return 0 != (slot.generation_ & 1);
+    }
+
+    static DataType *getObject(Slot &slot)
+    {
+        return reinterpret_cast<DataType *>(&slot.storage_);
+    }
+
+    uint32_t getFreeSlot()
+    {
+        if (endOfList_ != firstFreeSlot_)
+        {
+            uint32_t index = firstFreeSlot_;
+
+            firstFreeSlot_ = slots_[index].nextFree_;
+
+            return index;
+        }
+
+        if (capacity <= nextUnusedSlot_)
+        {
+            assert(false && "-- the slot map has not enough slot");
+            throw std::bad_alloc();
+        }
+
+        slots_[nextUnusedSlot_].generation_ = 0;
+
+        return nextUnusedSlot_++;
+    }
+
+    void returnSlot(uint32_t index)
+    {
+        slots_[index].nextFree_ = firstFreeSlot_;
+        firstFreeSlot_ = index;
+    }
+
+// 如果需要调试信息, 则需要获取内部状态, 这里要使用public
+#ifndef  _NS_OBJECT_POOL_DEBUG_
+private:
+#else
+public:
+#endif
+
+    Slot        *poolMemPtr_;       // 实际分配内存首地址, 用于释放
+    Slot        *slots_;            // 满足内存对齐要求的首地址
+    uint32_t    firstFreeSlot_;     // 空闲链表头, endOfList_表示为空
+    uint32_t    nextUnusedSlot_;    // 第一个从未分配过的块的索引
+    size_t      size_;              // 存活对象数
+};
+
+}   // NsLib
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef NS_THREAD_CACHED_OBJECT_POOL_H
+#define	NS_THREAD_CACHED_OBJECT_POOL_H
+
+#include "../NsInternalUse/NsCxx11Support.h"
+
+// for assert()
+#include <cassert>
+// for placement new and bad_alloc
+#include <new>
+#include <atomic>
+
+#include "../NsInternalUse/NsDebugInfo.h"
+#include "../NsUtility/NsUncopyale.h"
+#include "../NsSynchronization/NsLock.h"
+#include "NsObjectPool.h"
+
+namespace NsLib
+{
+
+/*!
+ * \class   ThreadCachedObjectPool NsPool.h
+ * \brief   带线程私有缓存(magazine)的Object Pool，多线程条件下使用。
+ * \ingroup NsPool
+ *
+ * \tparam  DataType - Object Pool中要存储对象的类型
+ * \tparam  [可选]size_t capacity - 共享Pool的容量[默认 = 1000]
+ * \tparam  [可选]Allocator - 内存分配器构造对象所需参数[默认 = UserDefaultAllocator]
+ * \tparam  [可选]size_t magazineSize - 每个线程缓存的最大对象个数[默认 = 32]
+ * \tparam  [可选]LockProxy - 保护共享Pool的锁类型[默认 = NsLcok]
+ *
+ * \details 每个线程持有一个容量为magazineSize的空闲块栈(magazine)，
+ *          分配和释放首先在magazine中完成，不需要任何同步。\n
+ *          magazine为空时，加锁一次从共享Pool中批量取出magazineSize / 2个块；
+ *          magazine已满时，加锁一次将magazineSize / 2个块批量归还给共享Pool。\n
+ *          线程退出时，magazine中剩余的块会自动归还给共享Pool。\n
+ *          共享Pool是每个ThreadCachedObjectPool专有的LocalObjectPool，
+ *          与NS_DEFINE_OBJECT_POOL_NAME定义的同类型ObjectPool互不影响。
+ *
+ * \note    其他线程magazine中缓存的块(每个线程最多magazineSize个)仍然计入共享Pool的容量，
+ *          当前线程无法使用，所以capacity至少要为
+ *          线程数 * magazineSize + 同时存活的对象数。\n
+ *          容量耗尽时，Debug模式下会触发断言，Release模式下抛出bad_alloc。\n
+ *          销毁、重新创建或重置Pool之后，各线程magazine中的旧块会被自动丢弃。
+ *
+ * \code
+ * // 示例：
+ * NS_DEFINE_THREAD_CACHED_OBJECT_POOL_NAME(BulletPool, Bullet, 100000);
+ *
+ * // 在启动工作线程之前创建。
+ * NS_CREATE_OBJECT_POOL(BulletPool);
+ *
+ * // 在任意线程中分配和删除，无需再使用NsLcok。
+ * Bullet *bullet = NS_NEW_FROM_OBJECT_POOL(BulletPool, x, y);
+ * NS_DELETE_IN_OBJECT_POOL(BulletPool, bullet);
+ *
+ * // 所有工作线程结束后销毁。
+ * NS_DESTROY_OBJECT_POOL(BulletPool);
+ * \endcode
+ *
+ * \see     ObjectPool
+ */
+template <typename  DataType,
+          size_t    capacity = 1000,
+          template  <typename>
+                    class Allocator = ::NsLib::UserDefaultAllocator,
+          size_t    magazineSize = 32,
+          typename  LockProxy = ::NsLib::NsLcok>
+class ThreadCachedObjectPool
+{
+    MAKE_CLASS_UNCOPYABLE(ThreadCachedObjectPool);
+
+    static_assert(2 <= magazineSize, "-- magazineSize must be at least 2");
+
+    typedef ::NsLib::LocalObjectPool<DataType, capacity, Allocator>
+            SharedPoolInstance;
+
+    // 每次与共享Pool交换的块数, 保留一半余量, 避免在边界上反复加锁
+    static const size_t batchSize_ = magazineSize / 2;
+
+    // 线程私有的空闲块栈
+    struct Magazine
+    {
+        Magazine() : count_{0}, generation_{0}
+        {
+        }
+
+        ~Magazine()
+        {
+            if (0 != count_)
+            {
+                ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+                if (generation_ == getSharedState().generation_)
+                {
+                    drain(*this, count_);
+                }
+            }
+        }
+
+        size_t      count_;
+        size_t      generation_;                // 填充时共享Pool的代数
+        DataType    *slots_[magazineSize];
+    };
+
+    // 所有线程共享的状态, generation_在每次create(), destroy()和reset()时递增
+    struct SharedState
+    {
+        SharedState() : generation_{0}
+        {
+        }
+
+        LockProxy               lock_;
+        std::atomic<size_t>     generation_;
+        SharedPoolInstance      pool_;          // 只在持有lock_时访问
+    };
+
+public:
+    typedef DataType    DataType_;
+
+    /*!
+     * \brief   创建共享的Object Pool，分配所需内存。
+     *
+     * \throw   bad_alloc
+     *
+     * \note    Debug模式下重复创建会触发断言。
+     */
+    static void create() NS_THROW(std::bad_alloc)
+    {
+        ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+        getSharedState().pool_.create();
+        ++getSharedState().generation_;
+    }
+
+    /*!
+     * \brief   销毁共享的Object Pool，并释放所有分配的内存。
+     *
+     * \note    各线程magazine中缓存的块随之失效，下次使用时自动丢弃。
+     */
+    static void destroy()
+    {
+        ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+        getSharedState().pool_.destroy();
+        ++getSharedState().generation_;
+    }
+
+    /*!
+     * \brief   一次丢弃所有对象，不调用析构函数。
+     *
+     * \note    各线程magazine中缓存的块随之失效，下次使用时自动丢弃。\n
+     *          magazine中的块不在共享Pool的空闲链表中，无法与存活对象区分，
+     *          所以这里不提供resetAndDestroyObjects()。
+     *
+     * \see     LocalObjectPool::reset()
+     */
+    static void reset()
+    {
+        ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+        getSharedState().pool_.reset();
+        ++getSharedState().generation_;
+    }
+
+    static DataType *getObjectMemory()
+    {
+        Magazine &magazine = getMagazine();
+
+        if (0 == magazine.count_ || !isMagazineValid(magazine))
+        {
+            refill(magazine);
+        }
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ThreadCachedObjectPool<",
+                        typeid(DataType).name(),
+                        ">::getObjectMemory()",
+                        magazine.slots_[magazine.count_ - 1]);
+#endif
+
+        return magazine.slots_[--magazine.count_];
+    }
+
+    static void deleteObject(DataType *objectPtr)
+    {
+        assert(nullptr != objectPtr && "-- objectPtr is nullptr");
+
+        objectPtr->~DataType();
+
+        deallocateMemory(objectPtr);
+    }
+
+    static void deallocateMemory(DataType *objectPtr)
+    {
+        assert(nullptr != objectPtr && "-- objectPtr is nullptr");
+
+#ifdef _NS_DEBUG_TRACE_MEMORRY_
+        NS_TRACE_MEMORY("ThreadCachedObjectPool<",
+                        typeid(DataType).name(),
+                        ">::deallocateMemory()",
+                        objectPtr);
+#endif
+
+        Magazine &magazine = getMagazine();
+
+        if (magazineSize == magazine.count_ || !isMagazineValid(magazine))
+        {
+            ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+            checkGeneration(magazine);
+
+            if (magazineSize == magazine.count_)
+            {
+                drain(magazine, batchSize_);
+            }
+        }
+
+        magazine.slots_[magazine.count_++] = objectPtr;
+    }
+
+private:
+    static SharedState &getSharedState()
+    {
+        static SharedState sharedState;
+
+        return sharedState;
+    }
+
+    static Magazine &getMagazine()
+    {
+        static thread_local Magazine magazine;
+
+        return magazine;
+    }
+
+    static bool isMagazineValid(const Magazine &magazine)
+    {
+        return magazine.generation_
+               == getSharedState().generation_.load(std::memory_order_relaxed);
+    }
+
+    // 共享Pool被销毁或重建后, magazine中的块已经失效, 直接丢弃,
+    // 调用者需要持有共享锁
+    static void checkGeneration(Magazine &magazine)
+    {
+        if (magazine.generation_ != getSharedState().generation_)
+        {
+            magazine.count_ = 0;
+            magazine.generation_ = getSharedState().generation_.load();
+        }
+    }
+
+    static void refill(Magazine &magazine)
+    {
+        ::NsLib::Lock<LockProxy> lockSharedPool{&getSharedState().lock_};
+
+        checkGeneration(magazine);
+
+        SharedPoolInstance &sharedPool = getSharedState().pool_;
+
+        assert(sharedPool.isCreated()
+               && "-- you have not create a object pool");
+
+        if (0 == sharedPool.currentCapacity_)
+        {
+            assert(false && "-- the object pool has not enough object");
+            throw std::bad_alloc();
+        }
+
+        size_t count = batchSize_ < sharedPool.currentCapacity_
+                       ? batchSize_ : sharedPool.currentCapacity_;
+
+        sharedPool.getMemoryBlocks(count, magazine.slots_ + magazine.count_);
+        magazine.count_ += count;
+    }
+
+    // 调用者需要持有共享锁
+    static void drain(Magazine &magazine, size_t count)
+    {
+        magazine.count_ -= count;
+
+        getSharedState().pool_.returnMemoryBlocks(
+            magazine.slots_ + magazine.count_, count);
+    }
+};
+
+/*!
+ * \brief   定义带线程私有缓存的Object Pool的名字。
+ * \ingroup NsPool
+ *
+ * \param   PoolName - ObjectPool名称
+ * \param   存储的数据类型
+ * \param   [可选]容量[默认=1000]
+ * \param   [可选]内存分配器[默认=UserDefaultAllocator]
+ * \param   [可选]每个线程缓存的最大对象个数[默认=32]
+ * \param   [可选]锁类型[默认=NsLcok]
+ *
+ * \details 定义后即可使用NS_CREATE_OBJECT_POOL, NS_NEW_FROM_OBJECT_POOL,
+ *          NS_DELETE_IN_OBJECT_POOL, NS_DESTROY_OBJECT_POOL进行操作。
+ *
+ * \see     ThreadCachedObjectPool
+ */
+#define NS_DEFINE_THREAD_CACHED_OBJECT_POOL_NAME(PoolName, ...) \
+    typedef ::NsLib::ThreadCachedObjectPool<__VA_ARGS__> PoolName
+
+}   // NsLib
+
+#endif
@@ -6,6 +6,18 @@
 #include "NsIntrusivePoolClass.h"
 #include "NsIntrusivePoolClassMultiInherit.h"
 
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <memory>
+
 namespace NsLibTest
 {
 
@@ -178,7 +190,1762 @@ void testIntrusiveObjectPoolUseMultiInheritIntrusivePoolClass()
         "IntrusivePoolClass() leave-----");
 }
 
+NS_DEFINE_THREAD_CACHED_OBJECT_POOL_NAME(ThreadCachedDoublePool,
+                                         double, 1000,
+                                         ::NsLib::UserDefaultAllocator, 8);
+
+void threadCachedObjectPoolWorker(int seed)
+{
+    double *ptrs[100] = {0};
+
+    for (int round = 0; round < 100; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            ptrs[i] = NS_NEW_FROM_OBJECT_POOL(ThreadCachedDoublePool,
+                                              seed + i);
+        }
+
+        for (int i = 0; i < 100; ++i)
+        {
+            assert(seed + i == *ptrs[i]);
+            NS_DELETE_IN_OBJECT_POOL(ThreadCachedDoublePool, ptrs[i]);
+        }
+    }
+}
+
+void testThreadCachedObjectPool()
+{
+    NS_TEST_MESSAGE("-----testThreadCachedObjectPool() entry-----");
+
+    NS_CREATE_OBJECT_POOL(ThreadCachedDoublePool);
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.push_back(std::thread{threadCachedObjectPoolWorker, i * 1000});
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    // 同类型的普通ObjectPool与线程缓存的共享Pool互不影响
+    NS_DEFINE_OBJECT_POOL_NAME(PlainDoublePool, double, 1000);
+    NS_CREATE_OBJECT_POOL(PlainDoublePool);
+
+    double *plain = NS_NEW_FROM_OBJECT_POOL(PlainDoublePool, 1.0);
+    double *cached = NS_NEW_FROM_OBJECT_POOL(ThreadCachedDoublePool, 2.0);
+
+    assert(plain != cached);
+    assert(1.0 == *plain);
+
+    NS_DELETE_IN_OBJECT_POOL(ThreadCachedDoublePool, cached);
+    NS_DELETE_IN_OBJECT_POOL(PlainDoublePool, plain);
+    NS_DESTROY_OBJECT_POOL(PlainDoublePool);
+
+    NS_DESTROY_OBJECT_POOL(ThreadCachedDoublePool);
+
+#ifdef NDEBUG
+    // 容量耗尽时抛出bad_alloc, Debug模式下会触发断言, 只在Release模式下检查
+    NS_DEFINE_THREAD_CACHED_OBJECT_POOL_NAME(SmallCachedPool,
+                                             double, 8,
+                                             ::NsLib::UserDefaultAllocator, 4);
+    NS_CREATE_OBJECT_POOL(SmallCachedPool);
+
+    double *ptrs[8] = {0};
+    bool exhausted = false;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        ptrs[i] = SmallCachedPool::getObjectMemory();
+    }
+
+    try
+    {
+        SmallCachedPool::getObjectMemory();
+    }
+    catch (const std::bad_alloc &)
+    {
+        exhausted = true;
+    }
+
+    if (!exhausted)
+    {
+        NS_TEST_MESSAGE("-- exhausted ThreadCachedObjectPool did not throw");
+        std::abort();
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        SmallCachedPool::deallocateMemory(ptrs[i]);
+    }
+
+    NS_DESTROY_OBJECT_POOL(SmallCachedPool);
+#endif
+
+    NS_TEST_MESSAGE("-----testThreadCachedObjectPool() leave-----");
+}
+
+NS_DEFINE_CONCURRENT_OBJECT_POOL_NAME(ConcurrentDoublePool, double, 400);
+
+void concurrentObjectPoolWorker(int seed)
+{
+    double *ptrs[100] = {0};
+
+    for (int round = 0; round < 100; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            ptrs[i] = NS_NEW_FROM_OBJECT_POOL(ConcurrentDoublePool, seed + i);
+        }
+
+        for (int i = 0; i < 100; ++i)
+        {
+            assert(seed + i == *ptrs[i]);
+            NS_DELETE_IN_OBJECT_POOL(ConcurrentDoublePool, ptrs[i]);
+        }
+    }
+}
+
+struct ConcurrentSmallObject
+{
+    char    data_[5];
+};
+
+NS_DEFINE_CONCURRENT_OBJECT_POOL_NAME(ConcurrentSmallPool,
+                                      ConcurrentSmallObject, 10);
+
+void testConcurrentObjectPool()
+{
+    NS_TEST_MESSAGE("-----testConcurrentObjectPool() entry-----");
+
+    NS_CREATE_OBJECT_POOL(ConcurrentDoublePool);
+
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        threads.push_back(std::thread{concurrentObjectPoolWorker, i * 1000});
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i].join();
+    }
+
+    NS_DESTROY_OBJECT_POOL(ConcurrentDoublePool);
+
+    // 对齐要求比块中原子变量小的类型, 销毁后可以重新创建
+    for (int round = 0; round < 2; ++round)
+    {
+        NS_CREATE_OBJECT_POOL(ConcurrentSmallPool);
+
+        ::NsLibTest::ConcurrentSmallObject *ptrs[10] = {0};
+
+        for (int i = 0; i < 10; ++i)
+        {
+            ptrs[i] = ConcurrentSmallPool::getObjectMemory();
+
+            assert(0 == (uintptr_t)(ptrs[i]) % alignof(std::atomic<uint32_t>));
+        }
+
+        for (int i = 0; i < 10; ++i)
+        {
+            ConcurrentSmallPool::deallocateMemory(ptrs[i]);
+        }
+
+        NS_DESTROY_OBJECT_POOL(ConcurrentSmallPool);
+    }
+
+    NS_TEST_MESSAGE("-----testConcurrentObjectPool() leave-----");
+}
+
+void testGrowableObjectPool()
+{
+    NS_TEST_MESSAGE("-----testGrowableObjectPool() entry-----");
+
+    // 容量依次为2, 4, 4(受上限限制)
+    NS_DEFINE_GROWABLE_OBJECT_POOL_NAME(GrowableDoublePool,
+                                        double, 2,
+                                        ::NsLib::UserDefaultAllocator,
+                                        200, 10);
+    NS_CREATE_OBJECT_POOL(GrowableDoublePool);
+
+    double *ptrs[10] = {0};
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            ptrs[i] = NS_NEW_FROM_OBJECT_POOL(GrowableDoublePool, i);
+        }
+
+        for (int i = 0; i < 10; ++i)
+        {
+            assert(i == *ptrs[i]);
+            NS_DELETE_IN_OBJECT_POOL(GrowableDoublePool, ptrs[i]);
+        }
+    }
+
+    NS_DESTROY_OBJECT_POOL(GrowableDoublePool);
+
+    NS_TEST_MESSAGE("-----testGrowableObjectPool() leave-----");
+}
+
+void testObjectPoolBatch()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolBatch() entry-----");
+
+    NS_DEFINE_OBJECT_POOL_NAME(BatchDoublePool, double, 10);
+    NS_CREATE_OBJECT_POOL(BatchDoublePool);
+
+    double *ptrs[10] = {0};
+
+    // 部分块来自空闲链表, 部分块来自未分配区域
+    NS_NEW_BATCH_FROM_OBJECT_POOL(BatchDoublePool, 4, ptrs, 1.0);
+    NS_DELETE_BATCH_IN_OBJECT_POOL(BatchDoublePool, ptrs + 2, 2);
+    NS_NEW_BATCH_FROM_OBJECT_POOL(BatchDoublePool, 8, ptrs + 2, 2.0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int j = i + 1; j < 10; ++j)
+        {
+            assert(ptrs[i] != ptrs[j]);
+        }
+    }
+
+    assert(2.0 == *ptrs[9]);
+
+    NS_DELETE_BATCH_IN_OBJECT_POOL(BatchDoublePool, ptrs, 10);
+    NS_NEW_BATCH_FROM_OBJECT_POOL(BatchDoublePool, 10, ptrs, 3.0);
+    NS_DELETE_BATCH_IN_OBJECT_POOL(BatchDoublePool, ptrs, 10);
+
+    NS_DESTROY_OBJECT_POOL(BatchDoublePool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolBatch() leave-----");
+}
+
+void testMemoryPool()
+{
+    NS_TEST_MESSAGE("-----testMemoryPool() entry-----");
+
+    NS_DEFINE_MEMORY_POOL_NAME(TestMemoryPool, 8 * 1024);
+    NS_CREATE_MEMORY_POOL(TestMemoryPool);
+
+    const size_t sizes[] = {1, 8, 9, 64, 65, 100, 1000, 4096, 5000};
+    const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    char *ptrs[count];
+
+    for (int round = 0; round < 100; ++round)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            ptrs[i] = static_cast<char *>(TestMemoryPool::allocate(sizes[i]));
+            assert(sizes[i] <= TestMemoryPool::getBlockSize(sizes[i]));
+
+            for (size_t j = 0; j < sizes[i]; ++j)
+            {
+                ptrs[i][j] = (char)(i);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            assert((char)(i) == ptrs[i][sizes[i] - 1]);
+            TestMemoryPool::deallocate(ptrs[i], sizes[i]);
+        }
+    }
+
+    NS_DESTROY_MEMORY_POOL(TestMemoryPool);
+
+    // slab只能容纳一个最大块, 每次最大块的分配都要用掉一整个新slab
+    NS_DEFINE_MEMORY_POOL_NAME(SmallSlabMemoryPool,
+                               ::NsLib::MemoryPoolSizeClass::MaxSize);
+    NS_CREATE_MEMORY_POOL(SmallSlabMemoryPool);
+
+    char *blocks[3] = {0};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        blocks[i] = static_cast<char *>(SmallSlabMemoryPool::allocate(
+                        ::NsLib::MemoryPoolSizeClass::MaxSize));
+
+        for (size_t j = 0; j < ::NsLib::MemoryPoolSizeClass::MaxSize; ++j)
+        {
+            blocks[i][j] = (char)(i);
+        }
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        assert((char)(i) == blocks[i][::NsLib::MemoryPoolSizeClass::MaxSize - 1]);
+        SmallSlabMemoryPool::deallocate(blocks[i],
+                                        ::NsLib::MemoryPoolSizeClass::MaxSize);
+    }
+
+    NS_DESTROY_MEMORY_POOL(SmallSlabMemoryPool);
+
+    NS_TEST_MESSAGE("-----testMemoryPool() leave-----");
+}
+
+void testLocalObjectPool()
+{
+    NS_TEST_MESSAGE("-----testLocalObjectPool() entry-----");
+
+    ::NsLib::LocalObjectPool< ::NsLibTest::MySimpleClass, 3> poolA;
+    ::NsLib::LocalObjectPool< ::NsLibTest::MySimpleClass, 3> poolB;
+
+    poolA.create();
+    poolB.create();
+
+    ::NsLibTest::MySimpleClass *ptrs[6] = {0};
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ptrs[i] = NS_NEW_FROM_LOCAL_OBJECT_POOL(poolA, i);
+        ptrs[i + 3] = NS_NEW_FROM_LOCAL_OBJECT_POOL(poolB, i + 3);
+
+        assert(poolA.isPointerValid(ptrs[i]));
+        assert(!poolB.isPointerValid(ptrs[i]));
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        NS_DELETE_IN_LOCAL_OBJECT_POOL(poolA, ptrs[i]);
+    }
+
+    // 整个Pool一次丢弃, 然后可以再次创建
+    poolB.destroy();
+    poolB.create();
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ptrs[i] = NS_NEW_FROM_LOCAL_OBJECT_POOL(poolB, i);
+    }
+
+    NS_TEST_MESSAGE("-----testLocalObjectPool() leave-----");
+}
+
+static int resetCounterObjectCount = 0;
+
+class ResetCounterObject
+{
+public:
+    ResetCounterObject()
+    {
+        ++resetCounterObjectCount;
+    }
+
+    ~ResetCounterObject()
+    {
+        --resetCounterObjectCount;
+    }
+
+    double  data_;
+};
+
+void testObjectPoolReset()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolReset() entry-----");
+
+    NS_DEFINE_OBJECT_POOL_NAME(ResetCounterPool,
+                               ::NsLibTest::ResetCounterObject, 10);
+    NS_CREATE_OBJECT_POOL(ResetCounterPool);
+
+    ::NsLibTest::ResetCounterObject *ptrs[10] = {0};
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            ptrs[i] = NS_NEW_FROM_OBJECT_POOL(ResetCounterPool);
+        }
+
+        NS_DELETE_IN_OBJECT_POOL(ResetCounterPool, ptrs[2]);
+        NS_DELETE_IN_OBJECT_POOL(ResetCounterPool, ptrs[5]);
+        assert(6 == resetCounterObjectCount);
+
+        NS_RESET_AND_DESTROY_OBJECTS_IN_OBJECT_POOL(ResetCounterPool);
+        assert(0 == resetCounterObjectCount);
+    }
+
+    // 重置之后整个容量都可以再次使用
+    for (int i = 0; i < 10; ++i)
+    {
+        ptrs[i] = NS_NEW_FROM_OBJECT_POOL(ResetCounterPool);
+    }
+
+    NS_RESET_OBJECT_POOL(ResetCounterPool);
+    resetCounterObjectCount = 0;
+
+    NS_DESTROY_OBJECT_POOL(ResetCounterPool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolReset() leave-----");
+}
+
+void testFrameArena()
+{
+    NS_TEST_MESSAGE("-----testFrameArena() entry-----");
+
+    ::NsLib::FrameArena<> frameArena;
+
+    frameArena.create(1024);
+
+    int *previous = nullptr;
+
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        int *current = frameArena.allocateArray<int>(16);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            current[i] = frame;
+        }
+
+        // 上一帧的数据在本帧中仍然有效
+        if (nullptr != previous)
+        {
+            assert(frame - 1 == previous[15]);
+        }
+
+        char *unaligned = static_cast<char *>(frameArena.allocate(3, 1));
+        double *aligned = frameArena.allocateArray<double>(1);
+
+        assert(nullptr != unaligned);
+        assert(0 == (uintptr_t)(aligned) % alignof(double));
+        (void)(unaligned);
+        (void)(aligned);
+
+        previous = current;
+        frameArena.nextFrame();
+        assert(0 == frameArena.getUsedSize());
+    }
+
+    frameArena.destroy();
+
+    NS_TEST_MESSAGE("-----testFrameArena() leave-----");
 }
 
+void testHugePageAllocator()
+{
+    NS_TEST_MESSAGE("-----testHugePageAllocator() entry-----");
+
+    typedef ::NsLib::HugePageAllocator<double> DoubleAllocator;
+
+    // 小块内存使用普通页
+    double *small = DoubleAllocator::allocate(sizeof(double) * 16);
+
+    assert(0 == (uintptr_t)(small) % 64);
+    small[15] = 1.0;
+    assert(::NsLib::HugePageType::Explicit != DoubleAllocator::getPageType(small));
+    DoubleAllocator::deallocate(small);
+
+#if defined(__linux__)
+    // 取整后剩余的空间能放下header时, 不会多映射一个大页
+    size_t hugePageSize = DoubleAllocator::getHugePageSize();
+    double *large = DoubleAllocator::allocate(hugePageSize - 64);
+    ::NsLib::HugePageType::HugePageTypes largeType =
+        DoubleAllocator::getPageType(large);
+
+    large[(hugePageSize - 64) / sizeof(double) - 1] = 2.0;
+    assert(0 == (uintptr_t)(large) % 64);
+    assert(hugePageSize == DoubleAllocator::getMappedSize(largeType));
+    (void)(largeType);
+    DoubleAllocator::deallocate(large);
 #endif
 
+    // 大块内存在Pool中使用, 页类型取决于系统配置
+    ::NsLib::LocalObjectPool<double, 1000000, ::NsLib::HugePageAllocator> pool;
+
+    pool.create();
+
+    double *value = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool, 3.0);
+
+    assert(3.0 == *value);
+
+    size_t mappedSize = 0;
+
+    for (size_t i = 0; i < ::NsLib::HugePageType::TypeCount; ++i)
+    {
+        mappedSize += DoubleAllocator::getMappedSize(
+                          (::NsLib::HugePageType::HugePageTypes)(i));
+    }
+
+    assert(sizeof(double) * 1000000 <= mappedSize);
+
+    NS_DELETE_IN_LOCAL_OBJECT_POOL(pool, value);
+    pool.destroy();
+
+    NS_TEST_MESSAGE("-----testHugePageAllocator() leave-----");
+}
+
+void testObjectPoolOccupancy()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolOccupancy() entry-----");
+
+    ::NsLib::LocalObjectPool<double,
+                             200,
+                             ::NsLib::UserDefaultAllocator,
+                             ::NsLib::ObjectPoolOption::OccupancyBitmap> pool;
+
+    pool.create();
+
+    double *ptrs[200] = {0};
+
+    for (int i = 0; i < 150; ++i)
+    {
+        ptrs[i] = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool, i);
+    }
+
+    for (int i = 1; i < 150; i += 2)
+    {
+        NS_DELETE_IN_LOCAL_OBJECT_POOL(pool, ptrs[i]);
+    }
+
+    // 按地址顺序只访问存活对象
+    double *previous = nullptr;
+    int liveCount = 0;
+
+    pool.forEachLive([&](double &value)
+    {
+        assert(0 == (int)(value) % 2);
+        assert(nullptr == previous || previous < &value);
+
+        previous = &value;
+        ++liveCount;
+    });
+
+    assert(75 == liveCount);
+
+    // 批量分配的对象同样会被记录
+    pool.getObjectMemoryBatch(100, ptrs);
+    pool.deallocateMemoryBatch(ptrs + 50, 50);
+
+    liveCount = 0;
+    pool.forEachLive([&](double &) { ++liveCount; });
+    assert(125 == liveCount);
+
+    pool.reset();
+
+    liveCount = 0;
+    pool.forEachLive([&](double &) { ++liveCount; });
+    assert(0 == liveCount);
+
+    pool.destroy();
+
+    // 开启位图后resetAndDestroyObjects()直接使用位图
+    NS_DEFINE_OBJECT_POOL_NAME(OccupancyCounterPool,
+                               ::NsLibTest::ResetCounterObject,
+                               100,
+                               ::NsLib::UserDefaultAllocator,
+                               ::NsLib::ObjectPoolOption::OccupancyBitmap);
+    NS_CREATE_OBJECT_POOL(OccupancyCounterPool);
+
+    ::NsLibTest::ResetCounterObject *objects[100] = {0};
+
+    resetCounterObjectCount = 0;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        objects[i] = NS_NEW_FROM_OBJECT_POOL(OccupancyCounterPool);
+    }
+
+    for (int i = 0; i < 100; i += 3)
+    {
+        NS_DELETE_IN_OBJECT_POOL(OccupancyCounterPool, objects[i]);
+    }
+
+    liveCount = 0;
+    OccupancyCounterPool::forEachLive(
+        [&](::NsLibTest::ResetCounterObject &) { ++liveCount; });
+    assert(resetCounterObjectCount == liveCount);
+
+    NS_RESET_AND_DESTROY_OBJECTS_IN_OBJECT_POOL(OccupancyCounterPool);
+    assert(0 == resetCounterObjectCount);
+
+    NS_DESTROY_OBJECT_POOL(OccupancyCounterPool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolOccupancy() leave-----");
+}
+
+void testObjectPoolStatistics()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolStatistics() entry-----");
+
+    NS_DEFINE_OBJECT_POOL_NAME(StatisticsPool,
+                               double,
+                               100,
+                               ::NsLib::UserDefaultAllocator,
+                               ::NsLib::ObjectPoolOption::Statistics);
+    NS_CREATE_OBJECT_POOL(StatisticsPool);
+
+    double *ptrs[100] = {0};
+
+    for (int i = 0; i < 60; ++i)
+    {
+        ptrs[i] = NS_NEW_FROM_OBJECT_POOL(StatisticsPool, i);
+    }
+
+    for (int i = 0; i < 20; ++i)
+    {
+        NS_DELETE_IN_OBJECT_POOL(StatisticsPool, ptrs[i]);
+    }
+
+    StatisticsPool::getObjectMemoryBatch(10, ptrs);
+    StatisticsPool::deallocateMemoryBatch(ptrs, 5);
+
+    ::NsLib::ObjectPoolStatistics statistics = StatisticsPool::getStatistics();
+
+    assert(45 == statistics.liveCount_);
+    assert(60 == statistics.highWaterMark_);
+    assert(70 == statistics.allocationCount_);
+    assert(25 == statistics.freeCount_);
+    assert(0 == statistics.failureCount_);
+    assert(45 * sizeof(double) == statistics.usedBytes_);
+    assert(100 * sizeof(double) <= statistics.reservedBytes_);
+
+    // 累计计数在reset()之后保留
+    NS_RESET_OBJECT_POOL(StatisticsPool);
+
+    statistics = StatisticsPool::getStatistics();
+    assert(0 == statistics.liveCount_);
+    assert(60 == statistics.highWaterMark_);
+    assert(70 == statistics.allocationCount_);
+
+    NS_DESTROY_OBJECT_POOL(StatisticsPool);
+
+    // 多个线程的计数分散在不同分片中, 汇总结果不变
+    ::NsLib::LocalObjectPool<double,
+                             4000,
+                             ::NsLib::UserDefaultAllocator,
+                             ::NsLib::ObjectPoolOption::Statistics> pool;
+    ::NsLib::NsLcok poolLock;
+
+    pool.create();
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                ::NsLib::Lock<::NsLib::NsLcok> lockPool{&poolLock};
+
+                double *value = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool, i);
+
+                if (0 == i % 2)
+                {
+                    NS_DELETE_IN_LOCAL_OBJECT_POOL(pool, value);
+                }
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    statistics = pool.getStatistics();
+
+    assert(4000 == statistics.allocationCount_);
+    assert(2000 == statistics.freeCount_);
+    assert(2000 == statistics.liveCount_);
+
+    pool.destroy();
+
+    NS_TEST_MESSAGE("-----testObjectPoolStatistics() leave-----");
+}
+
+void testObjectPoolAllocator()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolAllocator() entry-----");
+
+    typedef ::NsLib::ObjectPoolAllocator<int, 100> IntAllocator;
+
+    // 结点从Pool中分配, 超出容量后使用::operator new
+    std::list<int, IntAllocator> values;
+
+    for (int i = 0; i < 300; ++i)
+    {
+        values.push_back(i);
+    }
+
+    int expected = 0;
+
+    for (std::list<int, IntAllocator>::iterator it = values.begin();
+         it != values.end();
+         ++it)
+    {
+        assert(expected == *it);
+        ++expected;
+    }
+
+    values.clear();
+
+    // 只有n > 1的分配时Pool从未创建, 释放直接交给::operator delete
+    {
+        std::vector<short, ::NsLib::ObjectPoolAllocator<short, 10> > shorts;
+
+        shorts.reserve(4);
+        shorts.push_back(1);
+        shorts.reserve(8);
+
+        assert(1 == shorts[0]);
+    }
+
+    typedef std::pair<const int, double> SessionType;
+
+    std::map<int,
+             double,
+             std::less<int>,
+             ::NsLib::ObjectPoolAllocator<SessionType, 1000> > sessions;
+
+    std::unordered_map<int,
+                       double,
+                       std::hash<int>,
+                       std::equal_to<int>,
+                       ::NsLib::ObjectPoolAllocator<SessionType, 1000> > states;
+
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 500; ++i)
+        {
+            sessions[i] = i * 0.5;
+            states[i] = i * 2.0;
+        }
+
+        assert(500 == sessions.size());
+        assert(500 == states.size());
+        assert(10.0 == sessions[20]);
+        assert(40.0 == states[20]);
+
+        for (int i = 0; i < 500; i += 2)
+        {
+            sessions.erase(i);
+            states.erase(i);
+        }
+
+        assert(250 == sessions.size());
+        assert(250 == states.size());
+
+        sessions.clear();
+        states.clear();
+    }
+
+    assert((IntAllocator() == ::NsLib::ObjectPoolAllocator<double, 100>()));
+
+    NS_TEST_MESSAGE("-----testObjectPoolAllocator() leave-----");
+}
+
+#ifdef NS_MEMORY_RESOURCE_SUPPORT
+void testMemoryResource()
+{
+    NS_TEST_MESSAGE("-----testMemoryResource() entry-----");
+
+    // 结点从Pool中分配, 桶数组等大块请求交给upstream
+    ::NsLib::ObjectPoolResource<64, 200> nodeResource;
+
+    {
+        std::pmr::unordered_map<int, double> states{&nodeResource};
+        std::pmr::list<int> values{&nodeResource};
+
+        for (int i = 0; i < 500; ++i)
+        {
+            states[i] = i * 2.0;
+            values.push_back(i);
+        }
+
+        for (int i = 0; i < 500; i += 2)
+        {
+            states.erase(i);
+        }
+
+        assert(250 == states.size());
+        assert(42.0 == states[21]);
+        assert(499 == values.back());
+    }
+
+    // 所有内存在release()时一次释放
+    ::NsLib::MonotonicPoolResource<> requestResource(256);
+
+    for (int round = 0; round < 3; ++round)
+    {
+        std::pmr::vector<double> items{&requestResource};
+        std::pmr::string name{"a string that does not fit in the small buffer",
+                              &requestResource};
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            items.push_back(i);
+        }
+
+        assert(999.0 == items.back());
+        assert('a' == name[0]);
+
+        void *aligned = requestResource.allocate(8, 64);
+
+        assert(0 == (uintptr_t)(aligned) % 64);
+        (void)(aligned);
+
+        requestResource.release();
+    }
+
+    NS_TEST_MESSAGE("-----testMemoryResource() leave-----");
+}
+#endif
+
+void testPooledShared()
+{
+    NS_TEST_MESSAGE("-----testPooledShared() entry-----");
+
+    resetCounterObjectCount = 0;
+
+    {
+        std::vector<std::shared_ptr< ::NsLibTest::ResetCounterObject> > objects;
+
+        for (int round = 0; round < 3; ++round)
+        {
+            // 超过容量的部分使用::operator new
+            for (int i = 0; i < 150; ++i)
+            {
+                objects.push_back(
+                    ::NsLib::makePooledShared< ::NsLibTest::ResetCounterObject,
+                                              100>());
+                objects.back()->data_ = i;
+            }
+
+            assert(150 == resetCounterObjectCount);
+
+            std::shared_ptr< ::NsLibTest::ResetCounterObject> copy = objects[7];
+
+            assert(2 == copy.use_count());
+            assert(7.0 == copy->data_);
+
+            objects.clear();
+            assert(1 == copy.use_count());
+            assert(1 == resetCounterObjectCount);
+        }
+    }
+
+    assert(0 == resetCounterObjectCount);
+
+    NS_TEST_MESSAGE("-----testPooledShared() leave-----");
+}
+
+class ThrowingObject
+{
+public:
+    explicit ThrowingObject(bool shouldThrow)
+    {
+        if (shouldThrow)
+        {
+            throw std::bad_alloc();
+        }
+    }
+
+    double  data_;
+};
+
+void testObjectPoolEmplace()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolEmplace() entry-----");
+
+    NS_DEFINE_OBJECT_POOL_NAME(EmplaceCounterPool,
+                               ::NsLibTest::ResetCounterObject, 10,
+                               ::NsLib::UserDefaultAllocator,
+                               ::NsLib::ObjectPoolOption::Statistics);
+    NS_CREATE_OBJECT_POOL(EmplaceCounterPool);
+
+    static_assert(sizeof(EmplaceCounterPool::UniquePtr_)
+                  == sizeof(::NsLibTest::ResetCounterObject *),
+                  "-- the deleter must not take any space");
+
+    resetCounterObjectCount = 0;
+
+    {
+        EmplaceCounterPool::UniquePtr_ objects[10];
+
+        for (int i = 0; i < 10; ++i)
+        {
+            objects[i] = NS_EMPLACE_IN_OBJECT_POOL(EmplaceCounterPool);
+        }
+
+        assert(10 == resetCounterObjectCount);
+
+        objects[3].reset();
+        assert(9 == resetCounterObjectCount);
+        assert(9 == EmplaceCounterPool::getStatistics().liveCount_);
+    }
+
+    assert(0 == resetCounterObjectCount);
+    assert(0 == EmplaceCounterPool::getStatistics().liveCount_);
+
+    NS_DESTROY_OBJECT_POOL(EmplaceCounterPool);
+
+    // 构造函数抛出异常时块归还给Pool
+    NS_DEFINE_OBJECT_POOL_NAME(ThrowingPool,
+                               ::NsLibTest::ThrowingObject, 2,
+                               ::NsLib::UserDefaultAllocator,
+                               ::NsLib::ObjectPoolOption::Statistics);
+    NS_CREATE_OBJECT_POOL(ThrowingPool);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        try
+        {
+            ThrowingPool::UniquePtr_ object =
+                NS_EMPLACE_IN_OBJECT_POOL(ThrowingPool, true);
+            assert(false);
+        }
+        catch (const std::bad_alloc &)
+        {
+        }
+    }
+
+    assert(0 == ThrowingPool::getStatistics().liveCount_);
+
+    ThrowingPool::UniquePtr_ first = NS_EMPLACE_IN_OBJECT_POOL(ThrowingPool, false);
+    ThrowingPool::UniquePtr_ second = NS_EMPLACE_IN_OBJECT_POOL(ThrowingPool, false);
+
+    assert(first.get() != second.get());
+
+    first.reset();
+    second.reset();
+
+    NS_DESTROY_OBJECT_POOL(ThrowingPool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolEmplace() leave-----");
+}
+
+void testSlotMap()
+{
+    NS_TEST_MESSAGE("-----testSlotMap() entry-----");
+
+    typedef ::NsLib::SlotMap< ::NsLibTest::ResetCounterObject, 100> CounterSlotMap;
+
+    resetCounterObjectCount = 0;
+
+    {
+        CounterSlotMap slotMap;
+        CounterSlotMap::Handle handles[100];
+
+        slotMap.create();
+
+        for (int i = 0; i < 100; ++i)
+        {
+            handles[i] = slotMap.emplace();
+            assert(CounterSlotMap::invalidHandle_ != handles[i]);
+            slotMap.get(handles[i])->data_ = i;
+        }
+
+        assert(100 == slotMap.size());
+
+        // 删除后旧句柄失效, 块被复用时也不会访问到新对象
+        bool deleted = slotMap.deleteObject(handles[42]);
+        bool deletedAgain = slotMap.deleteObject(handles[42]);
+
+        assert(deleted);
+        assert(!deletedAgain);
+        assert(nullptr == slotMap.get(handles[42]));
+        (void)(deleted);
+        (void)(deletedAgain);
+
+        CounterSlotMap::Handle reused = slotMap.emplace();
+
+        assert(nullptr == slotMap.get(handles[42]));
+        assert(nullptr != slotMap.get(reused));
+        assert(reused != handles[42]);
+        assert(41.0 == slotMap.get(handles[41])->data_);
+        assert(nullptr == slotMap.get(CounterSlotMap::invalidHandle_));
+        assert(100 == resetCounterObjectCount);
+        (void)(reused);
+
+        // 析构时自动删除存活对象
+    }
+
+    assert(0 == resetCounterObjectCount);
+
+    // 构造函数抛出异常时块归还给SlotMap
+    typedef ::NsLib::SlotMap< ::NsLibTest::ThrowingObject, 1> ThrowingSlotMap;
+
+    ThrowingSlotMap throwingSlotMap;
+
+    throwingSlotMap.create();
+
+    try
+    {
+        throwingSlotMap.emplace(true);
+        assert(false);
+    }
+    catch (const std::bad_alloc &)
+    {
+    }
+
+    assert(0 == throwingSlotMap.size());
+
+    ThrowingSlotMap::Handle handle = throwingSlotMap.emplace(false);
+
+    assert(throwingSlotMap.isValid(handle));
+    (void)(handle);
+
+    throwingSlotMap.destroy();
+
+    NS_TEST_MESSAGE("-----testSlotMap() leave-----");
+}
+
+struct WorkerCounter
+{
+    uint64_t    count_;
+};
+
+struct alignas(128) WideWorkerCounter
+{
+    uint64_t    count_;
+};
+
+void testObjectPoolCacheLineStride()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolCacheLineStride() entry-----");
+
+    ::NsLib::LocalObjectPool< ::NsLibTest::WorkerCounter,
+                             8,
+                             ::NsLib::UserDefaultAllocator,
+                             ::NsLib::ObjectPoolOption::CacheLineStride> pool;
+
+    pool.create();
+
+    ::NsLibTest::WorkerCounter *counters[8];
+
+    for (int i = 0; i < 8; ++i)
+    {
+        counters[i] = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool);
+        counters[i]->count_ = 0;
+
+        // 每个对象独占一个cache line
+        assert(0 == (uintptr_t)(counters[i])
+                    % ::NsLib::ObjectPoolOption::CacheLineSize);
+        assert(pool.isPointerValid(counters[i]));
+    }
+
+    // 不同线程修改各自的计数
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 8; ++t)
+    {
+        ::NsLibTest::WorkerCounter *counter = counters[t];
+
+        threads.push_back(std::thread([counter]()
+        {
+            for (int i = 0; i < 100000; ++i)
+            {
+                ++counter->count_;
+            }
+        }));
+    }
+
+    for (size_t t = 0; t < threads.size(); ++t)
+    {
+        threads[t].join();
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        assert(100000 == counters[i]->count_);
+        NS_DELETE_IN_LOCAL_OBJECT_POOL(pool, counters[i]);
+    }
+
+    pool.destroy();
+
+    // 使用alignas指定更大的对齐
+    ::NsLib::LocalObjectPool< ::NsLibTest::WideWorkerCounter, 4> widePool;
+
+    widePool.create();
+
+    for (int i = 0; i < 4; ++i)
+    {
+        ::NsLibTest::WideWorkerCounter *counter = widePool.getObjectMemory();
+
+        assert(0 == (uintptr_t)(counter) % 128);
+        (void)(counter);
+    }
+
+    widePool.destroy();
+
+    NS_TEST_MESSAGE("-----testObjectPoolCacheLineStride() leave-----");
+}
+
+void testObjectPoolPrefault()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolPrefault() entry-----");
+
+    NS_DEFINE_OBJECT_POOL_NAME(PrefaultPool, ::NsLibTest::WorkerCounter, 10000);
+    NS_CREATE_PREFAULTED_OBJECT_POOL(PrefaultPool,
+                                     ::NsLib::ObjectPoolPrefault::Touch
+                                     | ::NsLib::ObjectPoolPrefault::Lock);
+
+    ::NsLibTest::WorkerCounter *counter = NS_NEW_FROM_OBJECT_POOL(PrefaultPool);
+
+    counter->count_ = 1;
+    NS_DELETE_IN_OBJECT_POOL(PrefaultPool, counter);
+    NS_DESTROY_OBJECT_POOL(PrefaultPool);
+
+    // 超过阈值时并行逐页写入, mlock()失败时Pool仍然可用
+    ::NsLib::LocalObjectPool< ::NsLibTest::WorkerCounter, 10 * 1024 * 1024> pool;
+
+    pool.create(::NsLib::ObjectPoolPrefault::Touch
+                | ::NsLib::ObjectPoolPrefault::Parallel
+                | ::NsLib::ObjectPoolPrefault::Lock);
+
+    ::NsLibTest::WorkerCounter *counters[1000];
+
+    pool.getObjectMemoryBatch(1000, counters);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        counters[i]->count_ = i;
+    }
+
+    assert(999 == counters[999]->count_);
+
+    pool.destroy();
+    assert(!pool.isMemoryLocked());
+
+    NS_TEST_MESSAGE("-----testObjectPoolPrefault() leave-----");
+}
+
+void testObjectPoolTypeTraits()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolTypeTraits() entry-----");
+
+    static_assert(::NsLib::TypeTraits<int>::IsPodType::value,
+                  "-- int is pod");
+    static_assert(::NsLib::TypeTraits<int *>::IsPodType::value,
+                  "-- pointer is pod");
+    static_assert(!::NsLib::TypeTraits< ::NsLibTest::WorkerCounter>
+                       ::IsPodType::value,
+                  "-- user defined type is not pod by default");
+    static_assert(::NsLib::TypeTraits< ::NsLibTest::WorkerCounter>
+                      ::HasTrivialDestructor::value,
+                  "-- WorkerCounter has trivial destructor");
+    static_assert(!::NsLib::TypeTraits< ::NsLibTest::ResetCounterObject>
+                       ::HasTrivialDestructor::value,
+                  "-- ResetCounterObject has non-trivial destructor");
+    static_assert(!::NsLib::TypeTraits<std::string>
+                       ::IsTriviallyCopyable::value,
+                  "-- std::string is not trivially copyable");
+
+    // 非trivial的析构函数在单个和批量删除时都会被调用
+    ::NsLib::LocalObjectPool< ::NsLibTest::ResetCounterObject, 10> pool;
+
+    pool.create();
+
+    ::NsLibTest::ResetCounterObject *objects[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        objects[i] = ::new((void *)(pool.getObjectMemory()))
+            ::NsLibTest::ResetCounterObject;
+    }
+
+    assert(4 == ::NsLibTest::resetCounterObjectCount);
+
+    pool.deleteObject(objects[0]);
+    assert(3 == ::NsLibTest::resetCounterObjectCount);
+
+    pool.deleteObjectBatch(objects + 1, 3);
+    assert(0 == ::NsLibTest::resetCounterObjectCount);
+
+    pool.destroy();
+
+    // trivially copyable的类型用memcpy()搬移
+    ::NsLibTest::WorkerCounter counters[3] = { {1}, {2}, {3} };
+    ::NsLibTest::WorkerCounter relocatedCounters[3];
+
+    ::NsLib::relocateObjects(relocatedCounters, counters, 3);
+    assert(3 == relocatedCounters[2].count_);
+
+    // 其他类型移动构造后析构原对象
+    typedef std::aligned_storage<sizeof(std::string),
+                                 alignof(std::string)>::type
+            StringStorage;
+
+    StringStorage source[2];
+    StringStorage destination[2];
+    std::string *sourceStrings = reinterpret_cast<std::string *>(source);
+    std::string *destinationStrings =
+        reinterpret_cast<std::string *>(destination);
+
+    ::new((void *)(sourceStrings)) std::string(64, 'a');
+    ::new((void *)(sourceStrings + 1)) std::string("b");
+
+    ::NsLib::relocateObjects(destinationStrings, sourceStrings, 2);
+    assert(std::string(64, 'a') == destinationStrings[0]);
+    assert("b" == destinationStrings[1]);
+
+    destinationStrings[0].~basic_string();
+    destinationStrings[1].~basic_string();
+
+    NS_TEST_MESSAGE("-----testObjectPoolTypeTraits() leave-----");
+}
+
+void testObjectPoolSnapshot()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolSnapshot() entry-----");
+
+    typedef ::NsLib::LocalObjectPool< ::NsLibTest::WorkerCounter,
+                                      1000,
+                                      ::NsLib::UserDefaultAllocator,
+                                      ::NsLib::ObjectPoolOption::OccupancyBitmap>
+            CounterPool;
+
+    const char *fileName = "NsTestPoolSnapshot.bin";
+    ::NsLibTest::WorkerCounter *counters[10];
+
+    {
+        CounterPool pool;
+
+        pool.create();
+        pool.getObjectMemoryBatch(10, counters);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            counters[i]->count_ = i;
+        }
+
+        pool.deallocateMemory(counters[3]);
+        pool.deallocateMemory(counters[7]);
+
+        bool saved = pool.saveSnapshot(fileName);
+
+        assert(saved);
+        (void)(saved);
+
+        // 保存之后Pool仍然可以继续使用
+        ::NsLibTest::WorkerCounter *reused = pool.getObjectMemory();
+
+        assert(counters[7] == reused);
+        (void)(reused);
+        pool.destroy();
+    }
+
+#if defined(__linux__)
+    CounterPool restoredPool;
+    bool restored = restoredPool.restoreSnapshot(fileName);
+
+    assert(restored);
+    (void)(restored);
+
+    uint64_t sum = 0;
+    size_t liveCount = 0;
+
+    restoredPool.forEachLive([&](::NsLibTest::WorkerCounter &counter)
+    {
+        sum += counter.count_;
+        ++liveCount;
+    });
+
+    assert(8 == liveCount);
+    assert(45 - 3 - 7 == sum);
+
+    // 空闲链表按保存时的顺序恢复, 之后是未分配区域
+    ::NsLibTest::WorkerCounter *first = restoredPool.getObjectMemory();
+    ::NsLibTest::WorkerCounter *second = restoredPool.getObjectMemory();
+    ::NsLibTest::WorkerCounter *third = restoredPool.getObjectMemory();
+
+    assert(first - second == 7 - 3);
+    assert(third - first == 10 - 7);
+    (void)(first);
+    (void)(second);
+    (void)(third);
+
+    restoredPool.destroy();
+
+    // 容量不同的Pool不能使用同一个快照
+    ::NsLib::LocalObjectPool< ::NsLibTest::WorkerCounter,
+                              999,
+                              ::NsLib::UserDefaultAllocator,
+                              ::NsLib::ObjectPoolOption::OccupancyBitmap>
+        otherPool;
+
+    restored = otherPool.restoreSnapshot(fileName);
+
+    assert(!restored);
+    assert(!otherPool.isCreated());
+
+    // 空闲链表中的块索引越界时拒绝恢复, 第一个空闲块是7
+    long offset = (long)(sysconf(_SC_PAGESIZE))
+                  + 7 * (long)(sizeof(::NsLibTest::WorkerCounter));
+    uint64_t badLink = 0x7FFFFFFF;
+    FILE *file = std::fopen(fileName, "r+b");
+
+    assert(nullptr != file);
+    std::fseek(file, offset, SEEK_SET);
+    std::fwrite(&badLink, sizeof(badLink), 1, file);
+    std::fclose(file);
+
+    CounterPool corruptedPool;
+
+    restored = corruptedPool.restoreSnapshot(fileName);
+
+    assert(!restored);
+    assert(!corruptedPool.isCreated());
+#endif
+
+    std::remove(fileName);
+
+    NS_TEST_MESSAGE("-----testObjectPoolSnapshot() leave-----");
+}
+
+void testNumaObjectPool()
+{
+    NS_TEST_MESSAGE("-----testNumaObjectPool() entry-----");
+
+    NS_DEFINE_NUMA_OBJECT_POOL_NAME(NumaCounterPool,
+                                    ::NsLibTest::WorkerCounter,
+                                    10000);
+
+    NS_CREATE_OBJECT_POOL(NumaCounterPool);
+
+    assert(1 <= NumaCounterPool::getNodeCount());
+    assert(NumaCounterPool::getCurrentNode() < NumaCounterPool::getNodeCount());
+
+    // 在各个线程中分配, 由另一个线程统一删除
+    const int threadCount = 4;
+    const int objectCount = 1000;
+    std::vector< ::NsLibTest::WorkerCounter *> counters(threadCount * objectCount);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads.push_back(std::thread([&counters, i]()
+        {
+            for (int j = 0; j < objectCount; ++j)
+            {
+                ::NsLibTest::WorkerCounter *counter =
+                    NS_NEW_FROM_OBJECT_POOL(NumaCounterPool);
+
+                counter->count_ = j;
+                counters[i * objectCount + j] = counter;
+            }
+        }));
+    }
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        threads[i].join();
+    }
+
+    std::thread([&counters]()
+    {
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            assert(NumaCounterPool::getNodeOf(counters[i])
+                   < NumaCounterPool::getNodeCount());
+            assert((uint64_t)(i % objectCount) == counters[i]->count_);
+
+            NS_DELETE_IN_OBJECT_POOL(NumaCounterPool, counters[i]);
+        }
+    }).join();
+
+    NS_DESTROY_OBJECT_POOL(NumaCounterPool);
+
+    // 销毁之后可以再次创建
+    NS_CREATE_OBJECT_POOL(NumaCounterPool);
+    NS_DELETE_IN_OBJECT_POOL(NumaCounterPool,
+                             NS_NEW_FROM_OBJECT_POOL(NumaCounterPool));
+    NS_DESTROY_OBJECT_POOL(NumaCounterPool);
+
+    NS_TEST_MESSAGE("-----testNumaObjectPool() leave-----");
+}
+
+void testObjectPoolCompact()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolCompact() entry-----");
+
+    // 非trivially copyable的类型移动构造后析构原对象
+    ::NsLib::LocalObjectPool<std::string,
+                             20,
+                             ::NsLib::UserDefaultAllocator,
+                             ::NsLib::ObjectPoolOption::OccupancyBitmap> pool;
+
+    pool.create();
+
+    std::string *strings[10];
+
+    for (int i = 0; i < 10; ++i)
+    {
+        strings[i] = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool, 32, (char)('0' + i));
+    }
+
+    pool.deleteObject(strings[1]);
+    pool.deleteObject(strings[3]);
+    pool.deleteObject(strings[5]);
+
+    std::map<std::string *, std::string *> relocations;
+
+    size_t movedCount = pool.compact(
+        [&](std::string *oldPtr, std::string *newPtr)
+    {
+        relocations[oldPtr] = newPtr;
+    });
+
+    assert(3 == movedCount);
+    (void)(movedCount);
+
+    // 最后的三个对象填入前面的空洞
+    assert(strings[1] == relocations[strings[9]]);
+    assert(strings[3] == relocations[strings[8]]);
+    assert(strings[5] == relocations[strings[7]]);
+    assert(std::string(32, '9') == *strings[1]);
+    assert(std::string(32, '7') == *strings[5]);
+
+    // 存活对象连续, 之后按地址顺序分配
+    size_t liveCount = 0;
+
+    pool.forEachLive([&](std::string &string)
+    {
+        assert(&string == strings[0] + liveCount);
+        (void)(string);
+        ++liveCount;
+    });
+
+    assert(7 == liveCount);
+
+    std::string *next = pool.getObjectMemory();
+    std::string *afterNext = pool.getObjectMemory();
+
+    assert(strings[7] == next);
+    assert(strings[8] == afterNext);
+
+    pool.deallocateMemory(next);
+    pool.deallocateMemory(afterNext);
+
+    movedCount = pool.compact();
+
+    assert(0 == movedCount);
+
+    pool.resetAndDestroyObjects();
+    pool.destroy();
+
+    // trivially copyable的类型直接memcpy()
+    NS_DEFINE_OBJECT_POOL_NAME(CompactPool, ::NsLibTest::WorkerCounter, 100);
+    NS_CREATE_OBJECT_POOL(CompactPool);
+
+    ::NsLibTest::WorkerCounter *counters[100];
+
+    NS_NEW_BATCH_FROM_OBJECT_POOL(CompactPool, 100, counters);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        counters[i]->count_ = i;
+    }
+
+    for (int i = 0; i < 90; ++i)
+    {
+        NS_DELETE_IN_OBJECT_POOL(CompactPool, counters[i]);
+    }
+
+    uint64_t sum = 0;
+
+    movedCount = CompactPool::compact(
+        [&](::NsLibTest::WorkerCounter *, ::NsLibTest::WorkerCounter *newPtr)
+    {
+        sum += newPtr->count_;
+    });
+
+    assert(10 == movedCount);
+    assert(945 == sum);
+    NS_DESTROY_OBJECT_POOL(CompactPool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolCompact() leave-----");
+}
+
+void testObjectPoolTrim()
+{
+    NS_TEST_MESSAGE("-----testObjectPoolTrim() entry-----");
+
+    const size_t capacity = 100000;
+
+    NS_DEFINE_OBJECT_POOL_NAME(TrimPool, ::NsLibTest::WorkerCounter, capacity);
+    NS_CREATE_OBJECT_POOL(TrimPool);
+
+    std::vector< ::NsLibTest::WorkerCounter *> counters(capacity);
+
+    NS_NEW_BATCH_FROM_OBJECT_POOL(TrimPool, capacity, counters.data());
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        counters[i]->count_ = i;
+    }
+
+    // 保留前面的10个对象和中间的一个对象
+    for (size_t i = 10; i < capacity; ++i)
+    {
+        if (capacity / 2 != i)
+        {
+            NS_DELETE_IN_OBJECT_POOL(TrimPool, counters[i]);
+        }
+    }
+
+    size_t tailSize = (capacity / 2) * sizeof(::NsLibTest::WorkerCounter);
+    size_t releasedSize = TrimPool::trim();
+
+#if defined(__linux__)
+    // 首尾不完整的页不会被释放
+    size_t pageSize = (size_t)(sysconf(_SC_PAGESIZE));
+
+    assert(tailSize - 2 * pageSize < releasedSize);
+    (void)(pageSize);
+#endif
+    (void)(tailSize);
+    (void)(releasedSize);
+
+    assert(capacity / 2 == counters[capacity / 2]->count_);
+
+    // 中间的空闲块仍在空闲链表中, 尾部变为未分配区域
+    std::vector< ::NsLibTest::WorkerCounter *> reused(capacity - 11);
+
+    TrimPool::getObjectMemoryBatch(capacity - 11, reused.data());
+
+    for (size_t i = 0; i < reused.size(); ++i)
+    {
+        reused[i]->count_ = 0;
+    }
+
+    assert(capacity / 2 == counters[capacity / 2]->count_);
+    assert(9 == counters[9]->count_);
+
+    TrimPool::deallocateMemoryBatch(reused.data(), reused.size());
+    NS_DELETE_IN_OBJECT_POOL(TrimPool, counters[capacity / 2]);
+
+    // 先整理再释放, 只剩前面的10个对象所在的页
+    TrimPool::compact();
+    releasedSize = TrimPool::trim();
+
+#if defined(__linux__)
+    assert(capacity * sizeof(::NsLibTest::WorkerCounter) - 3 * pageSize
+           < releasedSize);
+#endif
+
+    NS_DESTROY_OBJECT_POOL(TrimPool);
+
+    NS_TEST_MESSAGE("-----testObjectPoolTrim() leave-----");
+}
+
+void testRemoteFreeObjectPool()
+{
+    NS_TEST_MESSAGE("-----testRemoteFreeObjectPool() entry-----");
+
+    const size_t capacity = 1024;
+    const size_t messageCount = 100000;
+
+    ::NsLib::RemoteFreeObjectPool< ::NsLibTest::WorkerCounter, capacity> pool;
+
+    pool.create();
+    assert(pool.isOwnerThread());
+
+    // 拥有者自己的删除直接进入本地空闲链表
+    ::NsLibTest::WorkerCounter *counter = NS_NEW_FROM_LOCAL_OBJECT_POOL(pool);
+
+    pool.deleteObject(counter);
+
+    ::NsLibTest::WorkerCounter *reused = pool.getObjectMemory();
+
+    assert(counter == reused);
+    pool.deallocateMemory(reused);
+
+    // 生产者在拥有者线程中分配, 多个消费者线程删除, 远远超过容量
+    const int consumerCount = 2;
+    std::vector<std::atomic< ::NsLibTest::WorkerCounter *> > slots(capacity / 2);
+    std::atomic<uint64_t> deletedSum{0};
+    std::vector<std::thread> consumers;
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        slots[i].store(nullptr);
+    }
+
+    for (int i = 0; i < consumerCount; ++i)
+    {
+        consumers.push_back(std::thread([&, i]()
+        {
+            assert(!pool.isOwnerThread());
+
+            size_t deleted = 0;
+
+            while (deleted < messageCount / consumerCount)
+            {
+                for (size_t j = i; j < slots.size(); j += consumerCount)
+                {
+                    ::NsLibTest::WorkerCounter *message =
+                        slots[j].exchange(nullptr);
+
+                    if (nullptr != message)
+                    {
+                        deletedSum += message->count_;
+                        pool.deleteObject(message);
+                        ++deleted;
+                    }
+                }
+            }
+        }));
+    }
+
+    uint64_t createdSum = 0;
+
+    for (size_t i = 0; i < messageCount; )
+    {
+        std::atomic< ::NsLibTest::WorkerCounter *> &slot = slots[i % slots.size()];
+
+        if (nullptr == slot.load())
+        {
+            ::NsLibTest::WorkerCounter *message =
+                NS_NEW_FROM_LOCAL_OBJECT_POOL(pool);
+
+            message->count_ = i;
+            createdSum += i;
+            slot.store(message);
+            ++i;
+        }
+    }
+
+    for (int i = 0; i < consumerCount; ++i)
+    {
+        consumers[i].join();
+    }
+
+    assert(createdSum == deletedSum);
+
+    // 所有块都已归还, 可以再次分配到满
+    std::vector< ::NsLibTest::WorkerCounter *> counters(capacity);
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        counters[i] = pool.getObjectMemory();
+    }
+
+    pool.destroy();
+
+    NS_TEST_MESSAGE("-----testRemoteFreeObjectPool() leave-----");
+}
+
+static int intrusiveArrayObjectCount = 0;
+
+class IntrusiveArrayObject :
+    public ::NsLib::INewFromObjectPool<IntrusiveArrayObject, 16>
+{
+public:
+    IntrusiveArrayObject()
+    {
+        ++intrusiveArrayObjectCount;
+    }
+
+    ~IntrusiveArrayObject()
+    {
+        --intrusiveArrayObjectCount;
+    }
+
+    double  data_;
+};
+
+// 没有自己的Pool, 比块大
+class LargeIntrusiveArrayObject : public IntrusiveArrayObject
+{
+public:
+    double  extra_[4];
+};
+
+void testIntrusiveObjectPoolArray()
+{
+    NS_TEST_MESSAGE("-----testIntrusiveObjectPoolArray() entry-----");
+
+    NS_DEFINE_INTRUSIVE_OBJECT_POOL_NAME(IntrusiveArrayPool,
+                                         ::NsLibTest::IntrusiveArrayObject, 16);
+    NS_CREATE_INTRUSIVE_OBJECT_POOL(IntrusiveArrayPool);
+
+    ::NsLibTest::IntrusiveArrayObject *first =
+        new ::NsLibTest::IntrusiveArrayObject;
+    char *poolBegin = (char *)(first);
+    char *poolEnd = poolBegin
+                    + sizeof(::NsLibTest::IntrusiveArrayObject) * 16;
+
+    (void)(poolEnd);
+
+    // 空闲链表中没有回收过的块, 数组从first之后的块中划出
+    ::NsLibTest::IntrusiveArrayObject *array =
+        new ::NsLibTest::IntrusiveArrayObject[4];
+
+    assert(5 == intrusiveArrayObjectCount);
+    assert(poolBegin < (char *)(array) && (char *)(array + 4) <= poolEnd);
+
+    ::NsLibTest::IntrusiveArrayObject *next =
+        new ::NsLibTest::IntrusiveArrayObject;
+
+    assert((char *)(array + 4) <= (char *)(next));
+
+    delete [] array;
+
+    assert(2 == intrusiveArrayObjectCount);
+
+    // 回收的块不一定相邻, 改为从堆上分配
+    array = new ::NsLibTest::IntrusiveArrayObject[3];
+
+    assert(5 == intrusiveArrayObjectCount);
+    assert((char *)(array + 3) <= poolBegin || poolEnd <= (char *)(array));
+
+    delete [] array;
+
+    // 比DataType大的派生类对象从堆上分配, 删除时根据大小归还给堆
+    ::NsLibTest::LargeIntrusiveArrayObject *large =
+        new ::NsLibTest::LargeIntrusiveArrayObject;
+
+    assert((char *)(large + 1) <= poolBegin || poolEnd <= (char *)(large));
+
+    delete large;
+    delete first;
+    delete next;
+
+    assert(0 == intrusiveArrayObjectCount);
+
+    // 所有块都已归还
+    ::NsLibTest::IntrusiveArrayObject *ptrs[16] = {0};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        ptrs[i] = new ::NsLibTest::IntrusiveArrayObject;
+
+        assert(poolBegin <= (char *)(ptrs[i]) && (char *)(ptrs[i]) < poolEnd);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        delete ptrs[i];
+    }
+
+    NS_DESTROY_INTRUSIVE_OBJECT_POOL(IntrusiveArrayPool);
+
+    // 多继承时数组形式同样需要用NS_INTRUSIVE_OBJECT_POOL_MULTI_INHERIT引入
+    NS_DEFINE_INTRUSIVE_OBJECT_POOL_NAME(MultiInheritArrayPool,
+                           ::NsLibTest::DerivedInstrusivePoolClass,
+                           3);
+    NS_CREATE_INTRUSIVE_OBJECT_POOL(MultiInheritArrayPool);
+
+    ::NsLibTest::DerivedInstrusivePoolClass *derived =
+        new ::NsLibTest::DerivedInstrusivePoolClass[2];
+
+    delete [] derived;
+
+    NS_DESTROY_INTRUSIVE_OBJECT_POOL(MultiInheritArrayPool);
+
+    NS_TEST_MESSAGE("-----testIntrusiveObjectPoolArray() leave-----");
+}
+
+}
+
+#endif
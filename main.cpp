@@ -21,6 +21,33 @@ int main(int argc, char *argv[])
     NsLibTest::testObjectPoolUseMySimpleClass();
     NsLibTest::testIntrusiveObjectPoolUseIntrusivePoolClass();
     NsLibTest::testIntrusiveObjectPoolUseMultiInheritIntrusivePoolClass();
+    NsLibTest::testThreadCachedObjectPool();
+    NsLibTest::testConcurrentObjectPool();
+    NsLibTest::testGrowableObjectPool();
+    NsLibTest::testObjectPoolBatch();
+    NsLibTest::testMemoryPool();
+    NsLibTest::testLocalObjectPool();
+    NsLibTest::testObjectPoolReset();
+    NsLibTest::testFrameArena();
+    NsLibTest::testHugePageAllocator();
+    NsLibTest::testObjectPoolOccupancy();
+    NsLibTest::testObjectPoolStatistics();
+    NsLibTest::testObjectPoolAllocator();
+#ifdef NS_MEMORY_RESOURCE_SUPPORT
+    NsLibTest::testMemoryResource();
+#endif
+    NsLibTest::testPooledShared();
+    NsLibTest::testObjectPoolEmplace();
+    NsLibTest::testSlotMap();
+    NsLibTest::testObjectPoolCacheLineStride();
+    NsLibTest::testObjectPoolPrefault();
+    NsLibTest::testObjectPoolTypeTraits();
+    NsLibTest::testObjectPoolSnapshot();
+    NsLibTest::testNumaObjectPool();
+    NsLibTest::testObjectPoolCompact();
+    NsLibTest::testObjectPoolTrim();
+    NsLibTest::testRemoteFreeObjectPool();
+    NsLibTest::testIntrusiveObjectPoolArray();
 
 //    NsLibTest::testLock();
 //    NsLibTest::testSynchronizedObject();